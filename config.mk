@@ -41,21 +41,29 @@ THIS_DIR := $(subst config.mk,.,$(lastword $(MAKEFILE_LIST)))
 #DEMO_APP=hello-world
 #DEMO_APP=hpmcounter-demo
 #DEMO_APP=i2c-demo
+#DEMO_APP=interrupt-latency
+#DEMO_APP=interrupt-storm
 #DEMO_APP=interrupts-simple
 #DEMO_APP=interrupts-vectored
+#DEMO_APP=matrix-multiply
 #DEMO_APP=memory-test
 #DEMO_APP=memory-perf
 #DEMO_APP=mp-demo
+#DEMO_APP=mp-dispatch
 #DEMO_APP=mutex-demo
 #DEMO_APP=oob-demo
 #DEMO_APP=pic-interrupts
+#DEMO_APP=pic-irq-storm
 #DEMO_APP=plic-interrupts
+#DEMO_APP=plic-nested
 #DEMO_APP=plic-priority
 #DEMO_APP=pmp-demo
+#DEMO_APP=printf-throughput
 #DEMO_APP=privilege-drop
 #DEMO_APP=privilege-interrupts
 #DEMO_APP=privilege-interrupts-delegated
 #DEMO_APP=rdtime
+#DEMO_APP=snprintf-benchmark
 #DEMO_APP=spi-demo
 #DEMO_APP=tcm-demo
 #DEMO_APP=timing-demo
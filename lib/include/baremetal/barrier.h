@@ -16,10 +16,15 @@
 extern "C" {
 #endif
 
-/** \brief Simple barrier for hart synchronization */
+/**
+ * \brief Simple barrier for hart synchronization
+ *
+ * The arrival counter and the generation polled by the waiting harts are kept in separate cache lines,
+ * so that arriving harts do not disturb the harts already waiting.
+ */
 typedef struct {
-    volatile uint32_t waiting;
-    volatile uint32_t done;
+    volatile uint32_t waiting __attribute__((aligned(BM_CACHE_LINE_SIZE)));
+    volatile uint32_t generation __attribute__((aligned(BM_CACHE_LINE_SIZE)));
 } bm_barrier_t;
 
 /**
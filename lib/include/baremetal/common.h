@@ -18,6 +18,12 @@ extern "C" {
 #define USED   __attribute__((used))
 #define WEAK   __attribute__((weak))
 
+#ifdef TARGET_CACHE_LINE_SIZE
+    #define BM_CACHE_LINE_SIZE TARGET_CACHE_LINE_SIZE
+#else
+    #define BM_CACHE_LINE_SIZE 64
+#endif
+
 #if __riscv_xlen == 32
 typedef uint32_t xlen_t;
     #define BM_FMT_XLEN "0x%08" PRIx32
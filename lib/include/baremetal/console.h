@@ -0,0 +1,132 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef BAREMETAL_CONSOLE_H
+#define BAREMETAL_CONSOLE_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of the per-hart stdout buffer, can be set by CONFIG_CONSOLE_BUFFER_SIZE
+#ifndef BM_CONSOLE_BUFFER_SIZE
+    #define BM_CONSOLE_BUFFER_SIZE 128
+#endif
+
+/** \brief Buffering policies of the console output */
+typedef enum {
+    BM_CONSOLE_UNBUFFERED,      // Every write is passed to the backend immediately
+    BM_CONSOLE_LINE_BUFFERED,   // Output is flushed on newline, when the buffer is full and on exit
+    BM_CONSOLE_FULLY_BUFFERED,  // Output is flushed only when the buffer is full and on exit
+} bm_console_buffering_t;
+
+// Buffering policy used from the start, can be set by CONFIG_CONSOLE_BUFFERING
+#ifndef BM_CONSOLE_DEFAULT_BUFFERING
+    #define BM_CONSOLE_DEFAULT_BUFFERING BM_CONSOLE_LINE_BUFFERED
+#endif
+
+/** \brief Segment of data written by bm_console_writev */
+typedef struct {
+    const void *base; ///< Start of the segment
+    size_t      len;  ///< Length of the segment in bytes
+} bm_console_iovec_t;
+
+/** \brief Function called by bm_console_exit before the output is flushed */
+typedef void (*bm_console_exit_hook_t)(void);
+
+/** \brief Name of the console backend, defined by the syscalls implementation */
+extern const char bm_console_backend[];
+
+/**
+ * \brief Write data to the console device, implemented by the syscalls
+ *
+ * \param fd STDOUT_FILENO or STDERR_FILENO
+ * \param ptr Data to write
+ * \param len Number of bytes to write
+ */
+void bm_console_output(int fd, const void *ptr, size_t len);
+
+/**
+ * \brief Select when the buffered stdout is flushed
+ *
+ * \param buffering Buffering policy, BM_CONSOLE_DEFAULT_BUFFERING at startup
+ */
+void bm_console_set_buffering(bm_console_buffering_t buffering);
+
+/**
+ * \brief Get the current buffering policy
+ *
+ * \return Buffering policy of stdout
+ */
+bm_console_buffering_t bm_console_get_buffering(void);
+
+/**
+ * \brief Write data to stdout or stderr
+ *
+ * Stdout is collected in a per-hart buffer, so each hart outputs whole lines and a line costs a single
+ * trap to the debugger with the semihosting and Nexus backends. Stderr is not buffered, the pending
+ * stdout data are flushed before it to keep the order of the messages.
+ *
+ * \param fd STDOUT_FILENO or STDERR_FILENO
+ * \param ptr Data to write
+ * \param len Number of bytes to write
+ */
+void bm_console_write(int fd, const void *ptr, size_t len);
+
+/**
+ * \brief Write multiple segments of data to stdout or stderr at once
+ *
+ * The segments are gathered in the per-hart buffer, so that the whole call costs a single call
+ * to the backend (a single trap with semihosting or in the simulator) as long as the data fit
+ * into the buffer. This also applies to stderr and unbuffered stdout.
+ *
+ * \param fd STDOUT_FILENO or STDERR_FILENO
+ * \param iov Segments to write
+ * \param iovcnt Number of the segments
+ */
+void bm_console_writev(int fd, const bm_console_iovec_t *iov, unsigned iovcnt);
+
+/**
+ * \brief Write a single character to stdout
+ *
+ * \param c Character to write
+ */
+void bm_console_putc(char c);
+
+/**
+ * \brief Pass the stdout data buffered by the current hart to the backend
+ */
+void bm_console_flush(void);
+
+/**
+ * \brief Set the function called at exit before the console output is flushed
+ *
+ * \param hook Function to call, e.g. bm_log_flush, or NULL
+ */
+void bm_console_set_exit_hook(bm_console_exit_hook_t hook);
+
+/**
+ * \brief Flush the console output of all harts at exit, called by the _exit implementations
+ *
+ * Unlike functions registered by atexit, this also runs when the application returns from main,
+ * calls exit or aborts, as the startup code jumps to _exit directly.
+ */
+void bm_console_exit(void);
+
+/**
+ * \brief Get the number of calls to the backend made by the current hart
+ *
+ * In the simulator, each call is a trap handled by the host, whose duration is not reflected
+ * in the cycle count.
+ *
+ * \return Number of calls to bm_console_output
+ */
+unsigned bm_console_get_output_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BAREMETAL_CONSOLE_H */
@@ -4,6 +4,29 @@
 #ifndef BAREMETAL_CSR_H
 #define BAREMETAL_CSR_H
 
+/*
+ * Fields of the [m,s]status register, plain numbers so that they can be used from assembly as well
+ */
+#define BM_MSTATUS_SIE  0x0002
+#define BM_MSTATUS_MIE  0x0008
+#define BM_MSTATUS_SPIE 0x0020
+#define BM_MSTATUS_MPIE 0x0080
+#define BM_MSTATUS_SPP  0x0100
+#define BM_MSTATUS_MPP  0x1800
+
+/*
+ * The FS field tracks the state of the floating point unit: Off, Initial, Clean and Dirty. The
+ * hardware moves it to Dirty on any write of a floating point register; the Dirty to Clean transition
+ * (after the registers are saved) clears BM_MSTATUS_FS_DIRTY & ~BM_MSTATUS_FS_CLEAN.
+ */
+#define BM_MSTATUS_FS_MASK    0x6000
+#define BM_MSTATUS_FS_OFF     0x0000
+#define BM_MSTATUS_FS_INITIAL 0x2000
+#define BM_MSTATUS_FS_CLEAN   0x4000
+#define BM_MSTATUS_FS_DIRTY   0x6000
+
+#ifndef __ASSEMBLER__
+
 #include "baremetal/common.h"
 
 #define CSR_READ(csr, value)  __asm__ volatile("csrr %0, %1" : "=r"(value) : "i"(csr))
@@ -317,4 +340,6 @@ void   target_csr_clear_mask(const int csr, const xlen_t mask);
 }
 #endif
 
+#endif /* __ASSEMBLER__ */
+
 #endif /* BAREMETAL_CSR_H */
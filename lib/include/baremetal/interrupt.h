@@ -7,10 +7,31 @@
 #include "baremetal/csr.h"
 #include "baremetal/interrupt_low.h"
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** \brief Number of buckets of the per-trap histogram, the last one counts also all larger batches */
+#define BM_EXT_IRQ_STATS_BUCKETS 8
+
+/** \brief Load balancing of external interrupts among the harts of their affinity */
+typedef enum {
+    BM_EXT_IRQ_BALANCE_NONE,         ///< Interrupt is enabled on all harts of its affinity, the first one claims it
+    BM_EXT_IRQ_BALANCE_ROUND_ROBIN,  ///< Interrupt moves to the next hart of its affinity after each service
+    BM_EXT_IRQ_BALANCE_LEAST_LOADED, ///< Interrupt moves to the least loaded hart of its affinity
+} bm_ext_irq_balance_t;
+
+/** \brief Statistics of the external interrupt handler */
+typedef struct {
+    uint32_t traps;                              ///< Number of traps handled
+    uint32_t irqs;                               ///< Number of external interrupts serviced
+    uint32_t max_per_trap;                       ///< Largest number of interrupts serviced in one trap
+    uint32_t per_trap[BM_EXT_IRQ_STATS_BUCKETS]; ///< Numbers of traps which serviced 0, 1, 2, ... interrupts
+} bm_ext_irq_stats_t;
+
 /**
  * \brief Set function to handle given interrupt cause
  *
@@ -35,6 +56,30 @@ void bm_exception_set_handler(bm_exception_source_t cause, void (*func)(void));
  */
 void bm_ext_irq_set_handler(unsigned ext_irq_id, void (*func)(void));
 
+/**
+ * \brief Set hardware vectored handler of given interrupt cause
+ *
+ * The core jumps to the handler directly through the CLIC vector table, the handler must therefore
+ * be declared with __attribute__((interrupt)). Requires CLIC and bm_interrupt_init_vectored. A later
+ * bm_interrupt_set_handler call only replaces the handler used once the vectoring is disabled.
+ *
+ * \param cause Interrupt source to handle
+ * \param func Interrupt function to set as the handler, NULL to return to the handler set by
+ *             bm_interrupt_set_handler
+ */
+void bm_interrupt_set_shv_handler(bm_interrupt_source_t cause, void (*func)(void));
+
+/**
+ * \brief Set hardware vectored handler of given external interrupt source
+ *
+ * See bm_interrupt_set_shv_handler.
+ *
+ * \param ext_irq_id External interrupt source ID
+ * \param func Interrupt function to set as the handler, NULL to return to the handler set by
+ *             bm_ext_irq_set_handler
+ */
+void bm_ext_irq_set_shv_handler(unsigned ext_irq_id, void (*func)(void));
+
 /**
  * \brief Initialize interrupt handling for given privilege mode and interrupt or exceptions sources
  *
@@ -42,6 +87,24 @@ void bm_ext_irq_set_handler(unsigned ext_irq_id, void (*func)(void));
  */
 void bm_interrupt_init(bm_priv_mode_t priv_mode);
 
+/**
+ * \brief Initialize fast vectored interrupt handling
+ *
+ * Uses a vector table with a dedicated entry stub for each machine mode interrupt cause (MSIP, MTIP, MEIP).
+ * The stubs save only the caller-saved registers, and the caller-saved floating point registers only if
+ * mstatus.FS is Dirty, then call the handler set by bm_interrupt_set_handler directly. Exceptions and other
+ * causes are handled by the default handler. Only machine mode is supported.
+ *
+ * With CLIC, the vector table of the CLIC is generated from the handlers set by bm_interrupt_set_handler and
+ * bm_ext_irq_set_handler. Non-vectored interrupts enter a common stub, which claims them through mnxti with
+ * interrupts enabled, so that interrupts of a higher level (see bm_ext_irq_set_priority) preempt the handler,
+ * and services all pending interrupts before restoring the context. Individual inputs can be switched to
+ * hardware vectoring by bm_interrupt_set_shv_handler.
+ *
+ * \param priv_mode Privilege mode to initialize the interrupt handling for
+ */
+void bm_interrupt_init_vectored(bm_priv_mode_t priv_mode);
+
 /**
  * \brief Initialize external interrupt handler device
  */
@@ -61,6 +124,90 @@ int bm_ext_irq_claim(void);
  */
 void bm_ext_irq_complete(unsigned ext_irq_id);
 
+/**
+ * \brief Limit number of external interrupts serviced in one trap
+ *
+ * The library handler claims pending external interrupts until none is left. The budget
+ * bounds the time spent in one trap, the remaining interrupts cause a new trap.
+ *
+ * \param budget Maximum number of interrupts serviced in one trap, 0 for no limit (default)
+ */
+void bm_ext_irq_set_budget(unsigned budget);
+
+/**
+ * \brief Get statistics of the external interrupt handler of the current hart
+ *
+ * \param stats Structure to be filled
+ */
+void bm_ext_irq_get_stats(bm_ext_irq_stats_t *stats);
+
+/**
+ * \brief Reset statistics of the external interrupt handler of the current hart
+ */
+void bm_ext_irq_reset_stats(void);
+
+/**
+ * \brief Set priority of an external interrupt
+ *
+ * On PLIC, the priority is written to the source priority register, 0 disables the source.
+ * On CLIC, it is the interrupt level. On PIC, it is a software priority applied by the library handler.
+ * Sources with priority 0 get priority 1 when enabled by bm_ext_irq_enable.
+ *
+ * \param ext_irq_id External interrupt identifier
+ * \param priority Priority of the interrupt, higher value means higher priority
+ */
+void bm_ext_irq_set_priority(unsigned ext_irq_id, unsigned priority);
+
+/**
+ * \brief Set priority threshold of the current hart
+ *
+ * Only interrupts with priority above the threshold are delivered. Supported on PLIC and CLIC.
+ *
+ * \param threshold Priority threshold, 0 delivers all enabled interrupts
+ */
+void bm_ext_irq_set_threshold(unsigned threshold);
+
+/**
+ * \brief Get priority threshold of the current hart
+ *
+ * \return Priority threshold, 0 on controllers without threshold
+ */
+unsigned bm_ext_irq_get_threshold(void);
+
+/**
+ * \brief Enable or disable nesting of external interrupts in the library handler
+ *
+ * In nested mode, the machine mode handler raises the threshold to the priority of the claimed
+ * interrupt and re-enables interrupts while the registered handler runs, so that an interrupt with
+ * a higher priority preempts it. Each nesting level keeps a copy of the interrupted register file on
+ * the stack. Supported on PLIC only, CLIC preempts by levels in hardware.
+ *
+ * \param nested Enable nesting if true
+ */
+void bm_ext_irq_set_nested(bool nested);
+
+/**
+ * \brief Set harts which service an external interrupt
+ *
+ * Programs the PLIC enable bits of the contexts of the given harts. Without affinity, an interrupt
+ * is serviced by the hart which enabled it. Supported on PLIC only.
+ *
+ * \param ext_irq_id External interrupt identifier
+ * \param hart_mask Mask of hart IDs, bit N selects hart N
+ */
+void bm_ext_irq_set_affinity(unsigned ext_irq_id, uint32_t hart_mask);
+
+/**
+ * \brief Set load balancing of external interrupts with affinity to multiple harts
+ *
+ * When balancing, each interrupt is enabled only on one hart of its affinity at a time, and the
+ * library handler moves it to another hart after servicing it. The least loaded mode compares the
+ * numbers of interrupts serviced by the harts, see bm_ext_irq_get_stats. Supported on PLIC only.
+ *
+ * \param mode Balancing mode, BM_EXT_IRQ_BALANCE_NONE by default
+ */
+void bm_ext_irq_set_balance(bm_ext_irq_balance_t mode);
+
 /**
  * \brief Enable external interrupt
  *
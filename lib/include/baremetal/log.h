@@ -0,0 +1,117 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef BAREMETAL_LOG_H
+#define BAREMETAL_LOG_H
+
+#include "baremetal/common.h"
+#include "baremetal/csr.h"
+#include "baremetal/per_hart.h"
+#include "baremetal/ringbuf.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Size of the per-hart log buffer in bytes, a power of two, can be set by CONFIG_LOG_BUFFER_SIZE
+#ifndef BM_LOG_BUFFER_SIZE
+    #define BM_LOG_BUFFER_SIZE 512
+#endif
+
+// Maximum number of arguments of a log message, given by the alignment of the format strings
+#define BM_LOG_MAX_ARGS 7
+
+// Prefix of the lines emitted when draining the log, recognized by the host decoder
+#define BM_LOG_LINE_PREFIX "#BMLOG"
+
+/** \brief Per-hart buffer of the log records */
+BM_RINGBUF_DECLARE(bm_log_ring_t, BM_LOG_BUFFER_SIZE);
+
+extern BM_PER_HART bm_log_ring_t bm_log_ring;
+extern BM_PER_HART unsigned      bm_log_dropped;
+
+/**
+ * \brief Record a log message without formatting it
+ *
+ * The record consists of the address of the format string and the raw values of the arguments,
+ * which are converted to xlen_t. The message is formatted on the host by share/bmlog.py, which
+ * finds the format string in the ELF file of the application, therefore %s is only supported
+ * for constant strings. Must be called in machine mode, the record is written with interrupts
+ * disabled, so that it can also be called from interrupt handlers.
+ *
+ * Usage: bm_log("value %u at 0x%x\n", value, address);
+ */
+#define bm_log(...) BM_LOG_RECORD(__VA_ARGS__, 0)
+
+// Helper of bm_log, the trailing 0 only makes sure the argument list is never empty
+#define BM_LOG_RECORD(fmt, ...)                                                                   \
+    do                                                                                            \
+    {                                                                                             \
+        static const char bm_log_fmt[] __attribute__((aligned(BM_LOG_MAX_ARGS + 1))) = fmt;      \
+        xlen_t            bm_log_words[] = {(xlen_t)bm_log_fmt, __VA_ARGS__};                     \
+        _Static_assert(sizeof(bm_log_words) / sizeof(xlen_t) - 2 <= BM_LOG_MAX_ARGS,             \
+                       "Too many arguments of a log message");                                    \
+        bm_log_record(bm_log_words, sizeof(bm_log_words) / sizeof(xlen_t) - 1);                   \
+    } while (0)
+
+/**
+ * \brief Write a record to the current hart's log buffer, use bm_log instead
+ *
+ * \param words Address of the format string followed by the arguments
+ * \param count Number of the words
+ */
+static inline void bm_log_record(xlen_t *words, size_t count)
+{
+    size_t size = count * sizeof(xlen_t);
+    xlen_t mstatus;
+
+    // The number of arguments is kept in the low bits of the aligned format string address
+    words[0] |= count - 1;
+
+    __asm__ volatile("csrrci %0, mstatus, %1" : "=r"(mstatus) : "i"(BM_MSTATUS_MIE) : "memory");
+
+    if (bm_ringbuf_space(&bm_log_ring) >= size)
+    {
+        bm_ringbuf_push(&bm_log_ring, words, size);
+    }
+    else
+    {
+        bm_log_dropped++;
+    }
+
+    __asm__ volatile("csrs mstatus, %0" : : "r"(mstatus & BM_MSTATUS_MIE) : "memory");
+}
+
+/**
+ * \brief Register bm_log_flush to be called at exit, see bm_console_exit
+ */
+void bm_log_init(void);
+
+/**
+ * \brief Emit records from the log buffers of all harts to the console
+ *
+ * Intended to be called periodically, e.g. from the idle loop or by an otherwise idle hart. As it
+ * writes to the console, it must not be called from an interrupt handler.
+ * Each record is emitted as a line starting with BM_LOG_LINE_PREFIX, followed by the hart ID
+ * and the raw words in hexadecimal. If the log is already being drained, the call returns
+ * immediately.
+ *
+ * \param max_records Maximum number of records to emit
+ *
+ * \return Number of records emitted
+ */
+unsigned bm_log_drain(unsigned max_records);
+
+/**
+ * \brief Emit all records from the log buffers of all harts to the console
+ */
+void bm_log_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BAREMETAL_LOG_H */
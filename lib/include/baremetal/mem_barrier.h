@@ -16,6 +16,22 @@ static inline void bm_exec_fence(void)
     __asm__ volatile("fence rw, rw");
 }
 
+/**
+ * \brief Execute acquire fence, later memory accesses are not performed before the preceding loads
+ */
+static inline void bm_exec_fence_acquire(void)
+{
+    __asm__ volatile("fence r, rw" ::: "memory");
+}
+
+/**
+ * \brief Execute release fence, later stores are not performed before the preceding memory accesses
+ */
+static inline void bm_exec_fence_release(void)
+{
+    __asm__ volatile("fence rw, w" ::: "memory");
+}
+
 /**
  * \brief Execute fence.i instruction
  */
@@ -4,6 +4,8 @@
 #ifndef BAREMETAL_MP_H
 #define BAREMETAL_MP_H
 
+#include "baremetal/per_hart.h"
+
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -13,9 +15,34 @@ extern "C" {
 typedef void *bm_hart_func_arg_t;
 typedef void (*bm_hart_func_ptr_t)(bm_hart_func_arg_t);
 
+/** \brief Ways of waiting for a job used by the parked harts */
+typedef enum {
+    BM_HART_PARK_SPIN, // Poll the job flag continuously
+    BM_HART_PARK_WFI,  // Sleep in WFI until woken up by an IPI (targets with CLINT only)
+} bm_hart_park_mode_t;
+
+/**
+ * \brief Select how parked harts wait for a job
+ *
+ * Targets with a CLINT default to BM_HART_PARK_WFI, other targets support only BM_HART_PARK_SPIN.
+ * Harts already waiting apply the new mode after their next job.
+ *
+ * \param mode Park mode
+ */
+void bm_hart_set_park_mode(bm_hart_park_mode_t mode);
+
+/**
+ * \brief Get the currently selected park mode
+ *
+ * \return Park mode
+ */
+bm_hart_park_mode_t bm_hart_get_park_mode(void);
+
 /**
  * \brief Instruct hart to start executing a given function
  *
+ * The main hart (hart 0) accepts functions only while it waits in bm_hart_join.
+ *
  * \param hart_id ID of the hart to start execution on
  * \param func Function to execute
  * \param arg Argument to pass to the executed function
@@ -36,6 +63,8 @@ bool bm_hart_running(unsigned hart_id);
 /**
  * \brief Wait until execution on specified hart finishes
  *
+ * The main hart executes functions started on it by other harts while waiting.
+ *
  * \param hart_id ID of hart to wait for
  */
 void bm_hart_join(unsigned hart_id);
@@ -47,12 +76,18 @@ void bm_hart_join(unsigned hart_id);
  */
 void bm_hart_execute_all(bm_hart_func_ptr_t func);
 
+// ID of the current hart, stored to the per-hart data by the startup code
+extern BM_PER_HART unsigned bm_current_hartid;
+
 /**
  * \brief Get hart ID
  *
  * \return ID of the current hart
  */
-unsigned bm_get_hartid(void);
+static inline unsigned bm_get_hartid(void)
+{
+    return bm_current_hartid;
+}
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,92 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef BAREMETAL_PARALLEL_H
+#define BAREMETAL_PARALLEL_H
+
+#include "baremetal/common.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined(__riscv_atomic) && (TARGET_NUM_HARTS > 1)
+    #error "Parallel functionality is not defined for this target"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief Policies for distributing chunks of the iteration range among harts */
+typedef enum {
+    BM_PARALLEL_SCHEDULE_STATIC,  // Chunks are assigned to harts round-robin before the start
+    BM_PARALLEL_SCHEDULE_DYNAMIC, // Harts fetch the next chunk from a shared atomic counter
+} bm_parallel_schedule_t;
+
+/** \brief Function processing the [begin, end) subrange of a parallel loop */
+typedef void (*bm_parallel_for_func_t)(size_t begin, size_t end, void *ctx);
+
+/** \brief Function accumulating the [begin, end) subrange of a parallel reduction into acc */
+typedef uint64_t (*bm_parallel_reduce_func_t)(size_t begin, size_t end, uint64_t acc, void *ctx);
+
+/** \brief Function combining two partial results of a parallel reduction */
+typedef uint64_t (*bm_parallel_combine_func_t)(uint64_t a, uint64_t b);
+
+/**
+ * \brief Select how subsequent parallel loops split the iteration range
+ *
+ * \param schedule Scheduling policy, BM_PARALLEL_SCHEDULE_STATIC by default
+ */
+void bm_parallel_set_schedule(bm_parallel_schedule_t schedule);
+
+/**
+ * \brief Get the currently selected scheduling policy
+ *
+ * \return Scheduling policy used by bm_parallel_for and bm_parallel_reduce
+ */
+bm_parallel_schedule_t bm_parallel_get_schedule(void);
+
+/**
+ * \brief Execute a function over the [begin, end) range on all available harts
+ *
+ * The range is split into chunks of grain iterations. With static scheduling, grain of 0
+ * gives each hart a single contiguous block, with dynamic scheduling it selects a grain
+ * of roughly one eighth of the per-hart share. Harts already running a job are skipped.
+ *
+ * \param begin First index of the range
+ * \param end Index after the last index of the range
+ * \param grain Number of iterations in a chunk, or 0 for default
+ * \param func Function to execute on each chunk
+ * \param ctx User argument passed to each call of func
+ */
+void bm_parallel_for(size_t begin, size_t end, size_t grain, bm_parallel_for_func_t func, void *ctx);
+
+/**
+ * \brief Reduce the [begin, end) range on all available harts
+ *
+ * Each hart accumulates its chunks into a private partial result starting from identity,
+ * the partial results are then combined on the calling hart in the hart order.
+ *
+ * \param begin First index of the range
+ * \param end Index after the last index of the range
+ * \param grain Number of iterations in a chunk, or 0 for default (see bm_parallel_for)
+ * \param func Function accumulating each chunk
+ * \param combine Function combining partial results
+ * \param identity Initial value of each partial result
+ * \param ctx User argument passed to each call of func
+ *
+ * \return Combined result
+ */
+uint64_t bm_parallel_reduce(size_t                     begin,
+                            size_t                     end,
+                            size_t                     grain,
+                            bm_parallel_reduce_func_t  func,
+                            bm_parallel_combine_func_t combine,
+                            uint64_t                   identity,
+                            void                      *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BAREMETAL_PARALLEL_H */
@@ -0,0 +1,60 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef BAREMETAL_PER_HART_H
+#define BAREMETAL_PER_HART_H
+
+#include "baremetal/common.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Declare a variable in the per-hart (thread-local) storage
+ *
+ * Equivalent to __thread. The linker collects these variables into the .tdata and .tbss sections,
+ * the startup code creates a cache-line aligned copy of them for each hart and points the tp register
+ * to it. A plain access to the variable refers to the current hart's copy.
+ */
+#define BM_PER_HART __thread
+
+// Per-hart blocks and their stride, defined by the linker script
+extern char __tls_blocks[];
+extern char __tls_stride[];
+
+/**
+ * \brief Get start of the current hart's per-hart block
+ *
+ * \return Address of the block
+ */
+static inline uintptr_t bm_per_hart_block(void)
+{
+    uintptr_t block;
+    __asm__("mv %0, tp" : "=r"(block));
+    return block;
+}
+
+/**
+ * \brief Get start of given hart's per-hart block
+ *
+ * \param hart_id ID of the hart
+ *
+ * \return Address of the block
+ */
+static inline uintptr_t bm_per_hart_block_of(unsigned hart_id)
+{
+    return (uintptr_t)__tls_blocks + hart_id * (uintptr_t)__tls_stride;
+}
+
+/** \brief Access given hart's copy of a per-hart variable */
+#define bm_of_hart(var, hart_id) \
+    (*(__typeof__(&(var)))((uintptr_t)&(var) - bm_per_hart_block() + bm_per_hart_block_of(hart_id)))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BAREMETAL_PER_HART_H */
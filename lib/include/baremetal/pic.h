@@ -12,13 +12,39 @@
 extern "C" {
 #endif
 
+/** \brief Number of software priority levels of the PIC sources */
+#define BM_PIC_NUM_PRIORITIES 4
+
 /**
  * \brief Get the interrupt ID of the highest pending interrupt source
  *
+ * The lowest pending and enabled interrupt ID is returned.
+ *
  * \return Interrupt ID on success -1 on error
  */
 int bm_pic_get_irq(void);
 
+/**
+ * \brief Set software priority of given interrupt source
+ *
+ * The PIC itself has no priorities, they are applied by bm_pic_get_irq_by_priority.
+ * All sources have priority 0 by default.
+ *
+ * \param ext_irq_id External interrupt ID
+ * \param priority Priority from 0 (lowest) to BM_PIC_NUM_PRIORITIES - 1 (highest)
+ */
+void bm_pic_set_priority(unsigned ext_irq_id, unsigned priority);
+
+/**
+ * \brief Get the interrupt ID of the pending interrupt source with the highest software priority
+ *
+ * Sources of equal priority are ordered by their IDs as in bm_pic_get_irq. Without any priority
+ * set, this is equal to bm_pic_get_irq.
+ *
+ * \return Interrupt ID on success -1 on error
+ */
+int bm_pic_get_irq_by_priority(void);
+
 /**
  * \brief Clear given pending interrupt source
  */
@@ -19,6 +19,12 @@ typedef struct {
     bm_plic_regs_t *regs; ///< Pointer to the peripheral registers
 } bm_plic_t;
 
+/** \brief Structure describing threshold and claim/complete registers of a PLIC context */
+typedef struct {
+    volatile uint32_t THRESHOLD;
+    volatile uint32_t CLAIM_COMPLETE;
+} bm_plic_context_regs_t;
+
 /**
  * \brief Set the interrupt priority
  *
@@ -117,6 +123,39 @@ int bm_plic_claim(bm_plic_t *plic, unsigned context);
  */
 void bm_plic_complete(bm_plic_t *plic, unsigned context, unsigned ext_irq_id);
 
+/**
+ * \brief Get registers of given context, for repeated claims and completions without the index computation
+ *
+ * \param plic PLIC device
+ * \param context Hart identifier
+ *
+ * \return Pointer to the context registers
+ */
+bm_plic_context_regs_t *bm_plic_get_context_regs(bm_plic_t *plic, unsigned context);
+
+/**
+ * \brief Get the highest pending, unclaimed interrupt identifier of a context, and claim it
+ *
+ * \param context Context registers obtained by bm_plic_get_context_regs
+ *
+ * \return External interrupt identifier or -1
+ */
+static inline int bm_plic_context_claim(bm_plic_context_regs_t *context)
+{
+    return ((int)context->CLAIM_COMPLETE) - 1;
+}
+
+/**
+ * \brief Signal completion of interrupt handling to a context
+ *
+ * \param context Context registers obtained by bm_plic_get_context_regs
+ * \param ext_irq_id External interrupt identifier
+ */
+static inline void bm_plic_context_complete(bm_plic_context_regs_t *context, unsigned ext_irq_id)
+{
+    context->CLAIM_COMPLETE = ext_irq_id + 1;
+}
+
 #ifdef __cplusplus
 }
 #endif
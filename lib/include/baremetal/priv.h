@@ -6,6 +6,7 @@
 
 #include "baremetal/common.h"
 #include "baremetal/csr.h"
+#include "baremetal/per_hart.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -100,9 +101,9 @@ typedef struct {
 #endif
 } bm_register_file_t;
 
-extern volatile bm_priv_mode_t     bm_current_mode;
-extern volatile bm_register_file_t bm_priv_regs[4];
-extern volatile xlen_t             bm_priv_sp[4];
+extern BM_PER_HART volatile bm_priv_mode_t     bm_current_mode;
+extern BM_PER_HART volatile bm_register_file_t bm_priv_regs[4];
+extern BM_PER_HART volatile xlen_t             bm_priv_sp[4];
 
 /**
  * \brief Get the current privilege level
@@ -0,0 +1,222 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef BAREMETAL_RINGBUF_H
+#define BAREMETAL_RINGBUF_H
+
+#include "baremetal/mem_barrier.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Declare a lock-free single-producer single-consumer byte ring buffer type
+ *
+ * The size must be a power of two and is known at compile time, so the indices wrap by masking.
+ * The indices run freely and their difference is the number of stored bytes, therefore the whole
+ * buffer can be used. The head is written only by the producer, the tail only by the consumer,
+ * so the producer and the consumer may run on different harts or in an interrupt handler.
+ *
+ * \param name Name of the declared type
+ * \param size Capacity in bytes, a power of two
+ */
+#define BM_RINGBUF_DECLARE(name, size)   \
+    typedef struct {                     \
+        volatile size_t head;            \
+        volatile size_t tail;            \
+        uint8_t         buffer[(size)];  \
+    } name;                              \
+    _Static_assert((size) > 0 && ((size) & ((size) - 1)) == 0, "Ring buffer size must be a power of two")
+
+/** \brief Initialize a ring buffer declared by BM_RINGBUF_DECLARE, must not be used concurrently */
+#define bm_ringbuf_init(rb) ((rb)->head = 0, (rb)->tail = 0)
+
+/** \brief Capacity of a ring buffer in bytes */
+#define bm_ringbuf_size(rb) sizeof((rb)->buffer)
+
+/** \brief Number of bytes stored in a ring buffer */
+#define bm_ringbuf_count(rb) ((size_t)((rb)->head - (rb)->tail))
+
+/** \brief Number of bytes which can be pushed to a ring buffer */
+#define bm_ringbuf_space(rb) (bm_ringbuf_size(rb) - bm_ringbuf_count(rb))
+
+/** \brief Check whether a ring buffer is empty */
+#define bm_ringbuf_empty(rb) ((rb)->head == (rb)->tail)
+
+/** \brief Check whether a ring buffer is full */
+#define bm_ringbuf_full(rb) (bm_ringbuf_count(rb) == bm_ringbuf_size(rb))
+
+/** \brief Push up to len bytes from data, called by the producer, returns the number of pushed bytes */
+#define bm_ringbuf_push(rb, data, len) \
+    bm_ringbuf_push_raw(&(rb)->head, &(rb)->tail, (rb)->buffer, bm_ringbuf_size(rb), (data), (len))
+
+/** \brief Pop up to len bytes into data, called by the consumer, returns the number of popped bytes */
+#define bm_ringbuf_pop(rb, data, len) \
+    bm_ringbuf_pop_raw(&(rb)->head, &(rb)->tail, (rb)->buffer, bm_ringbuf_size(rb), (data), (len))
+
+/** \brief Push a single byte, called by the producer, returns 0 on success, -1 if the buffer is full */
+#define bm_ringbuf_push_byte(rb, byte) \
+    bm_ringbuf_push_byte_raw(&(rb)->head, &(rb)->tail, (rb)->buffer, bm_ringbuf_size(rb), (byte))
+
+/** \brief Pop a single byte, called by the consumer, returns the byte, or -1 if the buffer is empty */
+#define bm_ringbuf_pop_byte(rb) bm_ringbuf_pop_byte_raw(&(rb)->head, &(rb)->tail, (rb)->buffer, bm_ringbuf_size(rb))
+
+/**
+ * \brief Push data to a ring buffer, use bm_ringbuf_push instead
+ *
+ * \param head Write index, owned by the producer
+ * \param tail Read index, owned by the consumer
+ * \param buffer Storage of the ring buffer
+ * \param size Capacity of the ring buffer, a power of two
+ * \param data Data to push
+ * \param len Number of bytes to push
+ *
+ * \return Number of bytes pushed, less than len if the buffer got full
+ */
+static inline size_t bm_ringbuf_push_raw(volatile size_t       *head,
+                                         const volatile size_t *tail,
+                                         uint8_t               *buffer,
+                                         size_t                 size,
+                                         const void            *data,
+                                         size_t                 len)
+{
+    size_t h = *head;
+    size_t t = *tail;
+
+    // The consumer must be done with the freed bytes before they are overwritten
+    bm_exec_fence_acquire();
+
+    size_t space = size - (h - t);
+    if (len > space)
+    {
+        len = space;
+    }
+
+    size_t offset = h & (size - 1);
+    size_t first  = size - offset < len ? size - offset : len;
+
+    memcpy(buffer + offset, data, first);
+    memcpy(buffer, (const uint8_t *)data + first, len - first);
+
+    // Publish the data before the index
+    bm_exec_fence_release();
+    *head = h + len;
+
+    return len;
+}
+
+/**
+ * \brief Pop data from a ring buffer, use bm_ringbuf_pop instead
+ *
+ * \param head Write index, owned by the producer
+ * \param tail Read index, owned by the consumer
+ * \param buffer Storage of the ring buffer
+ * \param size Capacity of the ring buffer, a power of two
+ * \param data Buffer for the popped data
+ * \param len Maximum number of bytes to pop
+ *
+ * \return Number of bytes popped, less than len if the buffer got empty
+ */
+static inline size_t bm_ringbuf_pop_raw(const volatile size_t *head,
+                                        volatile size_t       *tail,
+                                        const uint8_t         *buffer,
+                                        size_t                 size,
+                                        void                  *data,
+                                        size_t                 len)
+{
+    size_t h = *head;
+    size_t t = *tail;
+
+    // The data must not be read before the index which published them
+    bm_exec_fence_acquire();
+
+    if (len > h - t)
+    {
+        len = h - t;
+    }
+
+    size_t offset = t & (size - 1);
+    size_t first  = size - offset < len ? size - offset : len;
+
+    memcpy(data, buffer + offset, first);
+    memcpy((uint8_t *)data + first, buffer, len - first);
+
+    // Finish reading the data before the bytes are handed back to the producer
+    bm_exec_fence_release();
+    *tail = t + len;
+
+    return len;
+}
+
+/**
+ * \brief Push a single byte to a ring buffer, use bm_ringbuf_push_byte instead
+ *
+ * \param head Write index, owned by the producer
+ * \param tail Read index, owned by the consumer
+ * \param buffer Storage of the ring buffer
+ * \param size Capacity of the ring buffer, a power of two
+ * \param byte Byte to push
+ *
+ * \return 0 on success, -1 if the buffer is full
+ */
+static inline int bm_ringbuf_push_byte_raw(volatile size_t       *head,
+                                           const volatile size_t *tail,
+                                           uint8_t               *buffer,
+                                           size_t                 size,
+                                           uint8_t                byte)
+{
+    size_t h = *head;
+
+    if (h - *tail == size)
+    {
+        return -1;
+    }
+
+    bm_exec_fence_acquire();
+    buffer[h & (size - 1)] = byte;
+    bm_exec_fence_release();
+    *head = h + 1;
+
+    return 0;
+}
+
+/**
+ * \brief Pop a single byte from a ring buffer, use bm_ringbuf_pop_byte instead
+ *
+ * \param head Write index, owned by the producer
+ * \param tail Read index, owned by the consumer
+ * \param buffer Storage of the ring buffer
+ * \param size Capacity of the ring buffer, a power of two
+ *
+ * \return Popped byte, or -1 if the buffer is empty
+ */
+static inline int bm_ringbuf_pop_byte_raw(const volatile size_t *head,
+                                          volatile size_t       *tail,
+                                          const uint8_t         *buffer,
+                                          size_t                 size)
+{
+    size_t t = *tail;
+
+    if (*head == t)
+    {
+        return -1;
+    }
+
+    bm_exec_fence_acquire();
+    uint8_t byte = buffer[t & (size - 1)];
+    bm_exec_fence_release();
+    *tail = t + 1;
+
+    return byte;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BAREMETAL_RINGBUF_H */
@@ -12,13 +12,34 @@
 extern "C" {
 #endif
 
+// Depth of the FIFOs of the Quad SPI IP, can be set by CONFIG_SPI_FIFO_DEPTH
+#ifndef BM_SPI_FIFO_DEPTH
+    #define BM_SPI_FIFO_DEPTH 16
+#endif
+
 /** \brief Structure describing SPI peripheral registers */
 typedef struct bm_spi_regs bm_spi_regs_t;
 
+/** \brief Function called on completion of an asynchronous transfer */
+typedef void (*bm_spi_callback_t)(void *ctx);
+
+/** \brief State of an asynchronous transfer */
+typedef struct {
+    const uint8_t    *txbuf;    ///< Data to transmit, or NULL
+    uint8_t          *rxbuf;    ///< Buffer for the received data, or NULL
+    size_t            size;     ///< Number of bytes to transfer
+    size_t            tx_pos;   ///< Number of bytes written to the TX FIFO
+    size_t            rx_pos;   ///< Number of bytes read from the RX FIFO
+    bm_spi_callback_t callback; ///< Function to call on completion, or NULL
+    void             *ctx;      ///< Argument of the callback
+    volatile bool     busy;     ///< Transfer in progress
+} bm_spi_async_t;
+
 /** \brief Structure holding data neccessary to service the SPI peripheral. */
 typedef struct {
     bm_spi_regs_t *regs;       ///< Pointer to the peripheral registers
     unsigned       ext_irq_id; ///< External interrupt identifier
+    bm_spi_async_t async;      ///< Asynchronous transfer in progress
 } bm_spi_t;
 
 /**
@@ -52,8 +73,68 @@ void bm_spi_write_byte(bm_spi_t *spi, uint8_t data);
  */
 uint8_t bm_spi_read_byte(bm_spi_t *spi);
 
+/**
+ * \brief Transmit and receive a block of data
+ *
+ * The transfer is pipelined, up to BM_SPI_FIFO_DEPTH bytes are kept in the FIFOs, so that the
+ * bus does not idle between the bytes. Must not be called during an asynchronous transfer.
+ *
+ * \param spi SPI device to use
+ * \param txbuf Data to transmit, 0xff is transmitted if NULL
+ * \param rxbuf Buffer to store the received data in, the data are discarded if NULL
+ * \param size Number of bytes to transfer
+ */
 void bm_spi_txrx_bufs(bm_spi_t *spi, const uint8_t *txbuf, uint8_t *rxbuf, size_t size);
 
+/**
+ * \brief Start an interrupt driven transfer of a block of data
+ *
+ * The TX FIFO is filled and the function returns, the rest of the data is transferred by
+ * bm_spi_handle_irq, which must be called from the handler of the SPI interrupt (see
+ * bm_ext_irq_set_handler). The buffers must stay valid and no other transfer may be started on
+ * the device until the transfer completes. The chip select is left as it is.
+ *
+ * \param spi SPI device to use
+ * \param txbuf Data to transmit, 0xff is transmitted if NULL
+ * \param rxbuf Buffer to store the received data in, the data are discarded if NULL
+ * \param size Number of bytes to transfer
+ * \param callback Function called from the interrupt handler on completion, or NULL
+ * \param ctx Argument of the callback
+ *
+ * \return 0 if the transfer was started, -1 if another transfer is in progress
+ */
+int bm_spi_transfer_async(bm_spi_t         *spi,
+                          const uint8_t    *txbuf,
+                          uint8_t          *rxbuf,
+                          size_t            size,
+                          bm_spi_callback_t callback,
+                          void             *ctx);
+
+/**
+ * \brief Check whether an asynchronous transfer is in progress
+ *
+ * \param spi SPI device
+ *
+ * \return true until the transfer completes
+ */
+bool bm_spi_transfer_busy(bm_spi_t *spi);
+
+/**
+ * \brief Wait for the completion of the asynchronous transfer
+ *
+ * \param spi SPI device
+ */
+void bm_spi_transfer_wait(bm_spi_t *spi);
+
+/**
+ * \brief Handle SPI interrupt, moves the data of the asynchronous transfer
+ *
+ * \param spi SPI device
+ *
+ * \return 0 if successful, non-zero value if no transfer is in progress
+ */
+int bm_spi_handle_irq(bm_spi_t *spi);
+
 /**
  * \brief Initialize SPI controller device
  *
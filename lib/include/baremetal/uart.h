@@ -4,6 +4,8 @@
 #ifndef BAREMETAL_UART_H
 #define BAREMETAL_UART_H
 
+#include "baremetal/ringbuf.h"
+
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -12,18 +14,13 @@
 extern "C" {
 #endif
 
-#define UART_FIFO_SIZE 128
+#define UART_FIFO_SIZE 128 // Must be a power of two
 
 /** \brief Structure describing UART peripheral registers */
 typedef struct bm_uart_regs bm_uart_regs_t;
 
-/** \brief FIFO structure */
-typedef struct bm_uart_fifo {
-    volatile size_t  start;
-    volatile size_t  pos;
-    volatile size_t  size;
-    volatile uint8_t buffer[UART_FIFO_SIZE];
-} bm_uart_fifo_t;
+/** \brief FIFO structure, the driver is the producer of the Tx FIFO and the consumer of the Rx FIFO */
+BM_RINGBUF_DECLARE(bm_uart_fifo_t, UART_FIFO_SIZE);
 
 /** \brief Data format options */
 typedef enum {
@@ -85,6 +82,20 @@ void bm_uart_init(bm_uart_t *uart, const bm_uart_config_t *config);
  */
 void bm_uart_transmit_byte(bm_uart_t *uart, uint8_t byte);
 
+/**
+ * \brief Function to transmit a buffer of data over UART
+ *
+ * In interrupt mode, the data is copied into the lock-free software FIFO and the function returns
+ * as soon as the data fit. The UART interrupt is masked only to start the transmission. The THRE
+ * interrupt then drains the FIFO, 16 bytes at a time. Without interrupts, the function blocks and
+ * fills the whole Tx FIFO each time it gets empty.
+ *
+ * \param uart Pointer to the UART driver structure
+ * \param buf Data to transmit
+ * \param len Number of bytes to transmit
+ */
+void bm_uart_write(bm_uart_t *uart, const uint8_t *buf, size_t len);
+
 /**
  * \brief Function to receive a single byte of data over UART
  *
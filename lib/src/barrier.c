@@ -5,7 +5,6 @@
 
 #include "baremetal/common.h"
 #include "baremetal/mem_barrier.h"
-#include "baremetal/mp.h"
 
 #include <stdint.h>
 
@@ -18,8 +17,8 @@ void bm_barrier_wait(bm_barrier_t *barrier UNUSED) {}
 
 void bm_barrier_init(bm_barrier_t *barrier)
 {
-    barrier->waiting = 0;
-    barrier->done    = 0;
+    barrier->waiting    = 0;
+    barrier->generation = 0;
 
     // Ensure updated data is visible from all harts
     bm_exec_fence();
@@ -27,29 +26,28 @@ void bm_barrier_init(bm_barrier_t *barrier)
 
 void bm_barrier_wait(bm_barrier_t *barrier)
 {
-    uint32_t tmp = 1;
-    __asm__ volatile("amoadd.w x0, %0, (%1)\n" : : "r"(tmp), "r"(&barrier->waiting));
+    uint32_t generation = barrier->generation;
+    uint32_t arrived    = 1;
 
-    // Wait until all harts are in this loop
-    while (barrier->waiting != TARGET_NUM_HARTS)
-        ;
+    // Read the generation before announcing the arrival
+    bm_exec_fence();
 
-    __asm__ volatile("amoadd.w x0, %0, (%1)\n" : : "r"(tmp), "r"(&barrier->done));
+    __asm__ volatile("amoadd.w %0, %1, (%2)\n" : "=r"(arrived) : "r"(arrived), "r"(&barrier->waiting) : "memory");
 
-    if (bm_get_hartid() == 0)
+    if (arrived == TARGET_NUM_HARTS - 1)
     {
-        // Wait until all harts are past the main loop
-        while (barrier->done != TARGET_NUM_HARTS)
-            ;
-
-        // Clean the barrier
-        bm_barrier_init(barrier);
+        // The last hart to arrive resets the counter and releases the others
+        barrier->waiting = 0;
+        bm_exec_fence();
+        barrier->generation = generation + 1;
     }
     else
     {
-        // Wait until the barrier is cleaned
-        while (barrier->done != 0)
+        // Wait until the last hart arrives
+        while (barrier->generation == generation)
             ;
     }
+
+    bm_exec_fence();
 }
 #endif
@@ -0,0 +1,230 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include "baremetal/console.h"
+
+#include "baremetal/common.h"
+#include "baremetal/csr.h"
+#include "baremetal/per_hart.h"
+#include "baremetal/platform.h"
+#include "baremetal/priv.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+
+static bm_console_buffering_t bm_console_buffering = BM_CONSOLE_DEFAULT_BUFFERING;
+
+static BM_PER_HART char     bm_console_buffer[BM_CONSOLE_BUFFER_SIZE];
+static BM_PER_HART size_t   bm_console_len;
+static BM_PER_HART unsigned bm_console_outputs;
+
+static bm_console_exit_hook_t bm_console_exit_hook;
+
+/**
+ * \brief Mask interrupts, so that a handler writing to the console cannot interleave with the buffer update
+ *
+ * Lower privilege modes cannot access mstatus, the interrupts stay enabled there.
+ *
+ * \return Original value of mstatus, to be passed to bm_console_unlock
+ */
+static inline xlen_t bm_console_lock(void)
+{
+    xlen_t mstatus = 0;
+
+    if (bm_current_mode == BM_PRIV_MODE_MACHINE)
+    {
+        __asm__ volatile("csrrci %0, mstatus, %1" : "=r"(mstatus) : "i"(BM_MSTATUS_MIE) : "memory");
+    }
+
+    return mstatus;
+}
+
+/**
+ * \brief Restore the interrupt mask saved by bm_console_lock
+ *
+ * \param mstatus Original value of mstatus
+ */
+static inline void bm_console_unlock(xlen_t mstatus)
+{
+    if (mstatus & BM_MSTATUS_MIE)
+    {
+        __asm__ volatile("csrsi mstatus, %0" : : "i"(BM_MSTATUS_MIE) : "memory");
+    }
+}
+
+/**
+ * \brief Pass data to the backend and count the call
+ *
+ * \param fd STDOUT_FILENO or STDERR_FILENO
+ * \param ptr Data to write
+ * \param len Number of bytes to write
+ */
+static void bm_console_emit(int fd, const void *ptr, size_t len)
+{
+    bm_console_outputs++;
+    bm_console_output(fd, ptr, len);
+}
+
+/**
+ * \brief Pass the buffered data to the backend as given file
+ *
+ * \param fd STDOUT_FILENO or STDERR_FILENO
+ */
+static void bm_console_flush_to(int fd)
+{
+    if (bm_console_len > 0)
+    {
+        bm_console_emit(fd, bm_console_buffer, bm_console_len);
+        bm_console_len = 0;
+    }
+}
+
+/**
+ * \brief Add data to the buffer, flushing it to given file when full
+ *
+ * \param fd STDOUT_FILENO or STDERR_FILENO
+ * \param data Data to add
+ * \param len Number of bytes to add
+ */
+static void bm_console_append(int fd, const char *data, size_t len)
+{
+    if (len > BM_CONSOLE_BUFFER_SIZE - bm_console_len)
+    {
+        bm_console_flush_to(fd);
+
+        // Data not fitting into an empty buffer are passed through without copying
+        if (len >= BM_CONSOLE_BUFFER_SIZE)
+        {
+            bm_console_emit(fd, data, len);
+            return;
+        }
+    }
+
+    memcpy(bm_console_buffer + bm_console_len, data, len);
+    bm_console_len += len;
+}
+
+void bm_console_set_buffering(bm_console_buffering_t buffering)
+{
+    bm_console_flush();
+    bm_console_buffering = buffering;
+}
+
+bm_console_buffering_t bm_console_get_buffering(void)
+{
+    return bm_console_buffering;
+}
+
+unsigned bm_console_get_output_count(void)
+{
+    return bm_console_outputs;
+}
+
+void bm_console_flush(void)
+{
+    xlen_t mstatus = bm_console_lock();
+
+    bm_console_flush_to(STDOUT_FILENO);
+
+    bm_console_unlock(mstatus);
+}
+
+void bm_console_set_exit_hook(bm_console_exit_hook_t hook)
+{
+    bm_console_exit_hook = hook;
+}
+
+void bm_console_exit(void)
+{
+    if (bm_console_exit_hook)
+    {
+        bm_console_exit_hook();
+    }
+
+    xlen_t mstatus = bm_console_lock();
+
+    // The other harts may have output pending, especially with full buffering
+    for (unsigned i = 0; i < TARGET_NUM_HARTS; ++i)
+    {
+        size_t *len = &bm_of_hart(bm_console_len, i);
+
+        if (*len > 0)
+        {
+            bm_console_emit(STDOUT_FILENO, bm_of_hart(bm_console_buffer, i), *len);
+            *len = 0;
+        }
+    }
+
+    bm_console_unlock(mstatus);
+}
+
+void bm_console_writev(int fd, const bm_console_iovec_t *iov, unsigned iovcnt)
+{
+    bool   direct  = fd != STDOUT_FILENO || bm_console_buffering == BM_CONSOLE_UNBUFFERED;
+    bool   newline = false;
+    xlen_t mstatus = bm_console_lock();
+
+    if (direct)
+    {
+        // Keep the order of the messages, the buffer is then used to gather the segments
+        bm_console_flush_to(STDOUT_FILENO);
+
+        if (iovcnt == 1)
+        {
+            bm_console_emit(fd, iov[0].base, iov[0].len);
+            bm_console_unlock(mstatus);
+            return;
+        }
+    }
+
+    for (unsigned i = 0; i < iovcnt; ++i)
+    {
+        bm_console_append(fd, (const char *)iov[i].base, iov[i].len);
+
+        if (bm_console_buffering == BM_CONSOLE_LINE_BUFFERED && !newline)
+        {
+            newline = memchr(iov[i].base, '\n', iov[i].len) != NULL;
+        }
+    }
+
+    if (direct || newline)
+    {
+        bm_console_flush_to(fd);
+    }
+
+    bm_console_unlock(mstatus);
+}
+
+void bm_console_write(int fd, const void *ptr, size_t len)
+{
+    bm_console_iovec_t iov = {.base = ptr, .len = len};
+
+    bm_console_writev(fd, &iov, 1);
+}
+
+void bm_console_putc(char c)
+{
+    if (bm_console_buffering == BM_CONSOLE_UNBUFFERED)
+    {
+        bm_console_emit(STDOUT_FILENO, &c, 1);
+        return;
+    }
+
+    xlen_t mstatus = bm_console_lock();
+
+    if (bm_console_len >= BM_CONSOLE_BUFFER_SIZE)
+    {
+        bm_console_flush_to(STDOUT_FILENO);
+    }
+
+    bm_console_buffer[bm_console_len++] = c;
+
+    if (bm_console_len == BM_CONSOLE_BUFFER_SIZE || (c == '\n' && bm_console_buffering == BM_CONSOLE_LINE_BUFFERED))
+    {
+        bm_console_flush_to(STDOUT_FILENO);
+    }
+
+    bm_console_unlock(mstatus);
+}
@@ -6,13 +6,15 @@
 #include "baremetal/common.h"
 #include "baremetal/csr.h"
 #include "baremetal/interrupt_low.h"
+#include "baremetal/mem_barrier.h"
 #include "baremetal/mp.h"
+#include "baremetal/mutex.h"
 #include "baremetal/platform.h"
 #include "baremetal/priv.h"
 #include "baremetal/verbose.h"
 
 #ifdef TARGET_HAS_PLIC
-    #include <baremetal/plic.h>
+    #include "baremetal/plic.h"
 #elif defined(TARGET_HAS_PIC)
     #include "baremetal/pic.h"
 #elif defined(TARGET_HAS_CLIC)
@@ -81,6 +83,77 @@ static void bm_exception_handler_unset(unsigned offset)
     bm_error("Fatal, ending execution.");
 }
 
+#ifdef TARGET_HAS_PLIC
+/** \brief PLIC device, cached by bm_interrupt_init */
+static bm_plic_t *bm_plic;
+
+/** \brief Context registers of the current hart, cached by bm_interrupt_init */
+static BM_PER_HART bm_plic_context_regs_t *bm_plic_context;
+
+/**
+ * \brief Cache the PLIC device and the context registers of the current hart
+ */
+static void bm_plic_cache_init(void)
+{
+    bm_plic         = (bm_plic_t *)target_peripheral_get(BM_PERIPHERAL_PLIC);
+    bm_plic_context = bm_plic_get_context_regs(bm_plic, bm_get_hartid());
+}
+
+/**
+ * \brief Get the cached context registers of the current hart, fill the cache if used before bm_interrupt_init
+ */
+static inline bm_plic_context_regs_t *bm_plic_get_context(void)
+{
+    if (!bm_plic_context)
+    {
+        bm_plic_cache_init();
+    }
+
+    return bm_plic_context;
+}
+
+/**
+ * \brief Get the cached PLIC device
+ */
+static inline bm_plic_t *bm_plic_get(void)
+{
+    if (!bm_plic)
+    {
+        bm_plic_cache_init();
+    }
+
+    return bm_plic;
+}
+#endif
+
+/**
+ * \brief Claim an external interrupt, inlined into the handler
+ */
+static inline int bm_ext_irq_claim_inline(void)
+{
+#ifdef TARGET_HAS_PLIC
+    return bm_plic_context_claim(bm_plic_get_context());
+#elif defined(TARGET_HAS_PIC)
+    return bm_pic_get_irq_by_priority();
+#else
+    return -1;
+#endif
+}
+
+/**
+ * \brief Complete an external interrupt, inlined into the handler
+ */
+static inline void bm_ext_irq_complete_inline(unsigned ext_irq_id)
+{
+#ifdef TARGET_HAS_PLIC
+    bm_plic_context_complete(bm_plic_get_context(), ext_irq_id);
+#elif defined(TARGET_HAS_PIC)
+    bm_pic_clear_irq(ext_irq_id);
+#else
+    (void)ext_irq_id;
+#endif
+}
+
 /** \brief Table with handlers for individual exception sources */
 static void (*bm_exc_handler_table[16])(void) = {0};
 
@@ -91,27 +164,222 @@ static void (*bm_interrupt_handler_table[TARGET_CLIC_NUM_INPUTS])(void) = {0};
 /** \brief Table with handlers for individual interrupt sources */
 static void (*bm_interrupt_handler_table[16])(void) = {0};
 
+#if defined(TARGET_HAS_PIC) && TARGET_PIC_NUM_INTERRUPTS > 32
+    #define BM_EXT_IRQ_NUM_SOURCES TARGET_PIC_NUM_INTERRUPTS
+#else
+    #define BM_EXT_IRQ_NUM_SOURCES 32
+#endif
+
 /** \brief Table with handlers for individual external interrupt sources */
-static void (*bm_ext_irq_handler_table[32])(void) = {0};
+static void (*bm_ext_irq_handler_table[BM_EXT_IRQ_NUM_SOURCES])(void) = {0};
 
-/** \brief Internal handler for external interrupts */
-void bm_ext_irq_handler(void)
+/** \brief Maximum number of external interrupts serviced in one trap, 0 for no limit */
+static unsigned bm_ext_irq_budget = 0;
+
+/** \brief Statistics of the external interrupt handler of the current hart */
+static BM_PER_HART bm_ext_irq_stats_t bm_ext_irq_stats;
+
+/** \brief Allow preemption of external interrupt handlers by interrupts of higher priority */
+static bool bm_ext_irq_nested = false;
+
+#ifdef TARGET_HAS_PLIC
+/** \brief Harts allowed to service each external interrupt, 0 for the hart which enabled it */
+static uint32_t bm_ext_irq_affinity[BM_EXT_IRQ_NUM_SOURCES] = {0};
+
+/** \brief Hart currently servicing each external interrupt when balancing */
+static uint8_t bm_ext_irq_target[BM_EXT_IRQ_NUM_SOURCES] = {0};
+
+/** \brief Selected load balancing mode */
+static bm_ext_irq_balance_t bm_ext_irq_balance = BM_EXT_IRQ_BALANCE_NONE;
+
+/** \brief Lock guarding the PLIC enable registers while interrupts are moved between harts */
+static bm_mutex_t bm_ext_irq_route_lock = 0;
+
+/**
+ * \brief Enable or disable an external interrupt for all harts in a mask
+ *
+ * \param ext_irq_id External interrupt identifier
+ * \param hart_mask Mask of harts
+ * \param en Enable or disable
+ */
+static void bm_ext_irq_route(unsigned ext_irq_id, uint32_t hart_mask, bool en)
 {
-    int pending = bm_ext_irq_claim();
+    bm_plic_t *plic = bm_plic_get();
 
-    if (pending == -1)
+    for (unsigned hart = 0; hart < TARGET_NUM_HARTS; ++hart)
+    {
+        if (hart_mask & (1UL << hart))
+        {
+            bm_plic_set_enable(plic, hart, ext_irq_id, en);
+        }
+    }
+}
+
+/**
+ * \brief Select the hart which services the next occurrence of an interrupt
+ *
+ * \param ext_irq_id External interrupt identifier
+ *
+ * \return Hart ID from the affinity mask of the interrupt
+ */
+static unsigned bm_ext_irq_select_target(unsigned ext_irq_id)
+{
+    uint32_t mask   = bm_ext_irq_affinity[ext_irq_id];
+    unsigned target = bm_ext_irq_target[ext_irq_id];
+
+    if (bm_ext_irq_balance == BM_EXT_IRQ_BALANCE_ROUND_ROBIN)
+    {
+        for (unsigned i = 1; i <= TARGET_NUM_HARTS; ++i)
+        {
+            unsigned hart = (target + i) % TARGET_NUM_HARTS;
+            if (mask & (1UL << hart))
+            {
+                return hart;
+            }
+        }
+    }
+    else
+    {
+        uint32_t least = UINT32_MAX;
+
+        for (unsigned hart = 0; hart < TARGET_NUM_HARTS; ++hart)
+        {
+            if ((mask & (1UL << hart)) && bm_of_hart(bm_ext_irq_stats, hart).irqs < least)
+            {
+                least  = bm_of_hart(bm_ext_irq_stats, hart).irqs;
+                target = hart;
+            }
+        }
+    }
+
+    return target;
+}
+
+/**
+ * \brief Move a serviced interrupt to the hart selected by the balancing mode
+ *
+ * Skipped if another hart is just moving an interrupt, the interrupt then stays on the current hart.
+ *
+ * \param ext_irq_id External interrupt identifier
+ */
+static void bm_ext_irq_rebalance(unsigned ext_irq_id)
+{
+    if (bm_ext_irq_balance == BM_EXT_IRQ_BALANCE_NONE || !bm_ext_irq_affinity[ext_irq_id] ||
+        bm_mutex_trylock(&bm_ext_irq_route_lock) != 0)
     {
         return;
     }
 
-    if (!bm_ext_irq_handler_table[pending])
+    unsigned current = bm_ext_irq_target[ext_irq_id];
+    unsigned target  = bm_ext_irq_select_target(ext_irq_id);
+
+    if (target != current)
     {
-        bm_error("An external interrupt with unset handler was triggered.");
+        bm_plic_t *plic = bm_plic_get();
+
+        bm_plic_set_enable(plic, current, ext_irq_id, 0);
+        bm_plic_set_enable(plic, target, ext_irq_id, 1);
+        bm_ext_irq_target[ext_irq_id] = target;
     }
 
-    bm_ext_irq_handler_table[pending]();
+    bm_mutex_unlock(&bm_ext_irq_route_lock);
+}
+#endif
+
+// Fields of mstatus describing the interrupted context, overwritten by a nested trap
+#define BM_MSTATUS_NESTED_MASK (BM_MSTATUS_MPP | BM_MSTATUS_MPIE)
+
+/**
+ * \brief Call handler of a claimed interrupt with interrupts of higher priority enabled
+ *
+ * The library handlers keep the interrupted context in the per-hart register file and the trap CSRs,
+ * a nested trap would overwrite them. Both are preserved on the stack while interrupts are enabled, and
+ * the privilege stack pointer is cleared so that the nested trap continues on the current stack.
+ *
+ * \param ext_irq_id Claimed external interrupt
+ */
+static void bm_ext_irq_call_nested(unsigned ext_irq_id)
+{
+#ifdef TARGET_HAS_PLIC
+    bm_plic_context_regs_t *context   = bm_plic_get_context();
+    uint32_t                threshold = context->THRESHOLD;
+    bm_register_file_t      regs      = bm_priv_regs[BM_PRIV_MODE_MACHINE];
+    xlen_t                  sp        = bm_priv_sp[BM_PRIV_MODE_MACHINE];
+    xlen_t                  mepc;
+    xlen_t                  mstatus;
+
+    CSR_READ(BM_CSR_MEPC, mepc);
+    CSR_READ(BM_CSR_MSTATUS, mstatus);
+
+    bm_priv_sp[BM_PRIV_MODE_MACHINE] = 0;
+
+    // Read back the threshold, so that it applies before interrupts are enabled
+    context->THRESHOLD = bm_plic_get_priority(bm_plic_get(), ext_irq_id);
+    (void)context->THRESHOLD;
 
-    bm_ext_irq_complete(pending);
+    bm_interrupt_enable(BM_PRIV_MODE_MACHINE);
+    bm_ext_irq_handler_table[ext_irq_id]();
+    bm_interrupt_disable(BM_PRIV_MODE_MACHINE);
+
+    context->THRESHOLD = threshold;
+
+    CSR_WRITE(BM_CSR_MEPC, mepc);
+    CSR_CLEAR(BM_CSR_MSTATUS, BM_MSTATUS_NESTED_MASK);
+    CSR_SET(BM_CSR_MSTATUS, mstatus & BM_MSTATUS_NESTED_MASK);
+
+    bm_priv_sp[BM_PRIV_MODE_MACHINE]   = sp;
+    bm_priv_regs[BM_PRIV_MODE_MACHINE] = regs;
+#else
+    bm_ext_irq_handler_table[ext_irq_id]();
+#endif
+}
+
+/**
+ * \brief Internal handler for external interrupts
+ *
+ * Claims and services pending interrupts until none is left or the budget is exhausted,
+ * so that a burst of interrupts pays the trap entry and exit only once.
+ */
+void bm_ext_irq_handler(void)
+{
+    unsigned budget   = bm_ext_irq_budget;
+    unsigned serviced = 0;
+
+    while (budget == 0 || serviced < budget)
+    {
+        int pending = bm_ext_irq_claim_inline();
+
+        if (pending == -1)
+        {
+            break;
+        }
+
+        if (!bm_ext_irq_handler_table[pending])
+        {
+            bm_error("An external interrupt with unset handler was triggered.");
+        }
+
+        if (bm_ext_irq_nested && bm_current_mode == BM_PRIV_MODE_MACHINE)
+        {
+            bm_ext_irq_call_nested(pending);
+        }
+        else
+        {
+            bm_ext_irq_handler_table[pending]();
+        }
+
+        bm_ext_irq_stats.irqs++;
+#ifdef TARGET_HAS_PLIC
+        bm_ext_irq_rebalance(pending);
+#endif
+
+        bm_ext_irq_complete_inline(pending);
+        ++serviced;
+    }
+
+    bm_ext_irq_stats.traps++;
+    bm_ext_irq_stats.max_per_trap = serviced > bm_ext_irq_stats.max_per_trap ? serviced : bm_ext_irq_stats.max_per_trap;
+    bm_ext_irq_stats.per_trap[serviced < BM_EXT_IRQ_STATS_BUCKETS ? serviced : BM_EXT_IRQ_STATS_BUCKETS - 1]++;
 }
 #endif
 
@@ -269,6 +537,19 @@ void bm_ext_irq_handler(void)
     BM_LOAD_F " f31, 62 * " BM_WORD_SIZE " (x1)\n"
 // clang-format on
 
+#define BM_STRINGIFY(x) #x
+#define BM_TO_STRING(x) BM_STRINGIFY(x)
+
+/**
+ * \brief FS field constants for the lazy floating point save
+ *
+ * Dirty has both bits of the field set, so a single register serves as the field mask and the Dirty value.
+ * The Dirty to Clean transition clears the bits of Dirty that are not part of Clean.
+ */
+_Static_assert(BM_MSTATUS_FS_DIRTY == BM_MSTATUS_FS_MASK, "Dirty must have all bits of the FS field set");
+#define BM_FS_MASK           BM_TO_STRING(BM_MSTATUS_FS_MASK)
+#define BM_FS_DIRTY_TO_CLEAN BM_TO_STRING(BM_MSTATUS_FS_DIRTY & ~BM_MSTATUS_FS_CLEAN)
+
 /**
  * \brief Helper macros to save/restore all other registers on/from addresses saved in x1 register
  */
@@ -276,19 +557,54 @@ void bm_ext_irq_handler(void)
     #define TARGET_SAVE_REGS TARGET_SAVE_EMB_REGS
     #define TARGET_LOAD_REGS TARGET_LOAD_EMB_REGS
     #define TARGET_NUM_REGS  15
-#elif defined(__riscv_flen)
-    #define TARGET_SAVE_REGS \
-        TARGET_SAVE_ALL_REGS \
-        TARGET_SAVE_FLOAT_REGS
-    #define TARGET_LOAD_REGS \
-        TARGET_LOAD_ALL_REGS \
-        TARGET_LOAD_FLOAT_REGS
-    #define TARGET_NUM_REGS 63
 #else
     #define TARGET_SAVE_REGS TARGET_SAVE_ALL_REGS
     #define TARGET_LOAD_REGS TARGET_LOAD_ALL_REGS
-    #define TARGET_NUM_REGS  31
+    #ifdef __riscv_flen
+        #define TARGET_NUM_REGS 63
+    #else
+        #define TARGET_NUM_REGS 31
+    #endif
+#endif
+
+// clang-format off
+#ifdef __riscv_flen
+    #ifdef TARGET_EXT_N
+        #error "Lazy floating point state saving needs the FS field, which is not available in user mode handlers"
+    #endif
+
+/**
+ * \brief Save floating point registers on/from addresses saved in x1 register, only if FS is Dirty
+ *
+ * The s1 register keeps the original FS value until the matching TARGET_LOAD_FLOAT_LAZY. After the save,
+ * FS is switched to Clean, so that it becomes Dirty again only if the handler writes a floating point register.
+ * Without a save, the handler cannot corrupt any live floating point value: a live value implies the Dirty state.
+ */
+    #define TARGET_SAVE_FLOAT_LAZY(status)              \
+        "csrr s1, " #status "\n"                       \
+        "li t1, " BM_FS_MASK "\n"                      \
+        "and s1, s1, t1\n"                             \
+        "bne s1, t1, 2f\n"                             \
+        TARGET_SAVE_FLOAT_REGS                         \
+        "li t1, " BM_FS_DIRTY_TO_CLEAN "\n"            \
+        "csrc " #status ", t1\n"                       \
+        "2:\n"
+
+/**
+ * \brief Restore floating point registers saved by TARGET_SAVE_FLOAT_LAZY and the original FS value
+ */
+    #define TARGET_LOAD_FLOAT_LAZY(status)              \
+        "li t1, " BM_FS_MASK "\n"                      \
+        "bne s1, t1, 3f\n"                             \
+        TARGET_LOAD_FLOAT_REGS                         \
+        "3:\n"                                         \
+        "csrc " #status ", t1\n"                       \
+        "csrs " #status ", s1\n"
+#else
+    #define TARGET_SAVE_FLOAT_LAZY(status)
+    #define TARGET_LOAD_FLOAT_LAZY(status)
 #endif
+// clang-format on
 
 /**
  * \brief Internal interrupt/exception handler routine
@@ -352,10 +668,20 @@ void bm_managed_handler_inner(bm_priv_mode_t new_mode)
 }
 
 // clang-format off
+/**
+ * \brief Helper macro computing address of a per-hart (thread-local) symbol with an offset into a register
+ */
+#define TLS_ADDR(reg, sym, offset)                                        \
+    "lui " reg ", %%tprel_hi(" sym " + " offset ")\n"                     \
+    "add " reg ", " reg ", tp, %%tprel_add(" sym " + " offset ")\n"       \
+    "addi " reg ", " reg ", %%tprel_lo(" sym " + " offset ")\n"
+
 /**
  * \brief Helper macro for creating default handler functions for different privilege modes
  *
- * - Save all registers in the dedicated structure for the handlers privilege mode.
+ * - Save all registers in the dedicated structure for the handlers privilege mode,
+ *   located in the per-hart data of the current hart (addressed relative to the tp register).
+ *   Floating point registers are saved only if the FS field of the status register is Dirty.
  * - Check whether a previous stack pointer is saved for the handlers privilege mode
  *   - if yes, load the saved value to the stack pointer.
  *   - otherwise, we are in handler called from the same privilege mode, and continue with the current stack.
@@ -363,16 +689,17 @@ void bm_managed_handler_inner(bm_priv_mode_t new_mode)
  * - Restore all registers, including stack pointer, from the dedicated structure.
  * - Exit the interrupt handler using mret, sret or uret instruction.
  */
-#define CREATE_DEFAULT_HANDLER(name, priv_mode, scratch, ret) \
+#define CREATE_DEFAULT_HANDLER(name, priv_mode, scratch, status, ret) \
     void __attribute__((naked, aligned(64))) name(void)       \
     {                                                         \
         __asm__ volatile("csrw " #scratch ", x1\n"            \
-                         "la x1, %0\n"                        \
+                         TLS_ADDR("x1", "bm_priv_regs", "%0") \
                          TARGET_SAVE_REGS                     \
+                         TARGET_SAVE_FLOAT_LAZY(status)       \
                          "mv t0, x1\n"                        \
                          "csrr x1, " #scratch " \n"           \
                          BM_STORE " x1, 0(t0)\n"              \
-                         "la t0, %1\n"                        \
+                         TLS_ADDR("t0", "bm_priv_sp", "%1")   \
                          BM_LOAD " t0, 0 (t0)\n"              \
                          "beqz t0, 1f\n"                      \
                          "mv sp, t0\n"                        \
@@ -380,12 +707,13 @@ void bm_managed_handler_inner(bm_priv_mode_t new_mode)
                          "la t0, %2\n"                        \
                          "li a0, %3\n"                        \
                          "jalr t0\n"                          \
-                         "la x1, %0\n"                        \
+                         TLS_ADDR("x1", "bm_priv_regs", "%0") \
+                         TARGET_LOAD_FLOAT_LAZY(status)       \
                          TARGET_LOAD_REGS                     \
                          BM_LOAD " x1, 0(x1)\n"               \
                          #ret                                 \
-                         ::"i"(&bm_priv_regs[priv_mode]),     \
-                         "i"(&bm_priv_sp[priv_mode]),         \
+                         ::"i"(priv_mode * sizeof(bm_register_file_t)), \
+                         "i"(priv_mode * sizeof(xlen_t)),     \
                          "i"(bm_managed_handler_inner),       \
                          "i"(priv_mode));                     \
     }
@@ -394,23 +722,414 @@ void bm_managed_handler_inner(bm_priv_mode_t new_mode)
 /**
  * \brief Separate trap vector for each privilege mode
  */
-CREATE_DEFAULT_HANDLER(bm_managed_handler_m, BM_PRIV_MODE_MACHINE, mscratch, mret)
+CREATE_DEFAULT_HANDLER(bm_managed_handler_m, BM_PRIV_MODE_MACHINE, mscratch, mstatus, mret)
 #ifdef TARGET_EXT_S
-CREATE_DEFAULT_HANDLER(bm_managed_handler_s, BM_PRIV_MODE_SUPERVISOR, sscratch, sret)
+CREATE_DEFAULT_HANDLER(bm_managed_handler_s, BM_PRIV_MODE_SUPERVISOR, sscratch, sstatus, sret)
 #endif
 #ifdef TARGET_EXT_N
-CREATE_DEFAULT_HANDLER(bm_managed_handler_u, BM_PRIV_MODE_USER, uscratch, uret)
+CREATE_DEFAULT_HANDLER(bm_managed_handler_u, BM_PRIV_MODE_USER, uscratch, ustatus, uret)
+#endif
+
+// clang-format off
+/**
+ * \brief Frame of the fast handlers, 16 caller-saved registers, sp, privilege mode, FS field, padding
+ *        and 20 caller-saved floating point registers
+ */
+#ifdef __riscv_flen
+    #define BM_FAST_FRAME_WORDS 40
+#else
+    #define BM_FAST_FRAME_WORDS 20
+#endif
+
+#ifdef __riscv_32e
+    #define BM_FAST_SAVE_REGS                           \
+        BM_STORE " ra, 0 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " t0, 1 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " t1, 2 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " t2, 3 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a0, 4 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a1, 5 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a2, 6 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a3, 7 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a4, 8 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a5, 9 * " BM_WORD_SIZE " (sp)\n"
+
+    #define BM_FAST_LOAD_REGS                           \
+        BM_LOAD " ra, 0 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " t0, 1 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " t1, 2 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " t2, 3 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a0, 4 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a1, 5 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a2, 6 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a3, 7 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a4, 8 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a5, 9 * " BM_WORD_SIZE " (sp)\n"
+#else
+    #define BM_FAST_SAVE_REGS                           \
+        BM_STORE " ra, 0 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " t0, 1 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " t1, 2 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " t2, 3 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a0, 4 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a1, 5 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a2, 6 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a3, 7 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a4, 8 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a5, 9 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_STORE " a6, 10 * " BM_WORD_SIZE " (sp)\n"    \
+        BM_STORE " a7, 11 * " BM_WORD_SIZE " (sp)\n"    \
+        BM_STORE " t3, 12 * " BM_WORD_SIZE " (sp)\n"    \
+        BM_STORE " t4, 13 * " BM_WORD_SIZE " (sp)\n"    \
+        BM_STORE " t5, 14 * " BM_WORD_SIZE " (sp)\n"    \
+        BM_STORE " t6, 15 * " BM_WORD_SIZE " (sp)\n"
+
+    #define BM_FAST_LOAD_REGS                           \
+        BM_LOAD " ra, 0 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " t0, 1 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " t1, 2 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " t2, 3 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a0, 4 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a1, 5 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a2, 6 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a3, 7 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a4, 8 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a5, 9 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_LOAD " a6, 10 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_LOAD " a7, 11 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_LOAD " t3, 12 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_LOAD " t4, 13 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_LOAD " t5, 14 * " BM_WORD_SIZE " (sp)\n"     \
+        BM_LOAD " t6, 15 * " BM_WORD_SIZE " (sp)\n"
+#endif
+
+#ifdef __riscv_flen
+    /**
+     * \brief Save caller-saved floating point registers only if mstatus.FS is Dirty
+     *
+     * The FS field is switched to Clean, so that the state is marked Dirty again only if the handler
+     * itself writes a floating point register. Without a save, the handler cannot corrupt any live
+     * floating point value: a live value implies the Dirty state.
+     */
+    #define BM_FAST_SAVE_FLOAT                               \
+        "csrr t0, mstatus\n"                                 \
+        "li t1, " BM_FS_MASK "\n"                            \
+        "and t0, t0, t1\n"                                   \
+        BM_STORE " t0, 18 * " BM_WORD_SIZE " (sp)\n"         \
+        "bne t0, t1, 3f\n"                                   \
+        BM_STORE_F " f0, 20 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_STORE_F " f1, 21 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_STORE_F " f2, 22 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_STORE_F " f3, 23 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_STORE_F " f4, 24 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_STORE_F " f5, 25 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_STORE_F " f6, 26 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_STORE_F " f7, 27 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_STORE_F " f10, 28 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f11, 29 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f12, 30 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f13, 31 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f14, 32 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f15, 33 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f16, 34 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f17, 35 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f28, 36 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f29, 37 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f30, 38 * " BM_WORD_SIZE " (sp)\n"      \
+        BM_STORE_F " f31, 39 * " BM_WORD_SIZE " (sp)\n"      \
+        "li t1, " BM_FS_DIRTY_TO_CLEAN "\n"                  \
+        "csrc mstatus, t1\n"                                 \
+        "3:\n"
+
+    /**
+     * \brief Restore caller-saved floating point registers if they were saved and the original mstatus.FS
+     */
+    #define BM_FAST_LOAD_FLOAT                               \
+        BM_LOAD " t0, 18 * " BM_WORD_SIZE " (sp)\n"          \
+        "li t1, " BM_FS_MASK "\n"                            \
+        "bne t0, t1, 4f\n"                                   \
+        BM_LOAD_F " f0, 20 * " BM_WORD_SIZE " (sp)\n"        \
+        BM_LOAD_F " f1, 21 * " BM_WORD_SIZE " (sp)\n"        \
+        BM_LOAD_F " f2, 22 * " BM_WORD_SIZE " (sp)\n"        \
+        BM_LOAD_F " f3, 23 * " BM_WORD_SIZE " (sp)\n"        \
+        BM_LOAD_F " f4, 24 * " BM_WORD_SIZE " (sp)\n"        \
+        BM_LOAD_F " f5, 25 * " BM_WORD_SIZE " (sp)\n"        \
+        BM_LOAD_F " f6, 26 * " BM_WORD_SIZE " (sp)\n"        \
+        BM_LOAD_F " f7, 27 * " BM_WORD_SIZE " (sp)\n"        \
+        BM_LOAD_F " f10, 28 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f11, 29 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f12, 30 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f13, 31 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f14, 32 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f15, 33 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f16, 34 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f17, 35 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f28, 36 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f29, 37 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f30, 38 * " BM_WORD_SIZE " (sp)\n"       \
+        BM_LOAD_F " f31, 39 * " BM_WORD_SIZE " (sp)\n"       \
+        "4:\n"                                               \
+        "csrc mstatus, t1\n"                                 \
+        "csrs mstatus, t0\n"
+#else
+    #define BM_FAST_SAVE_FLOAT
+    #define BM_FAST_LOAD_FLOAT
+#endif
+
+#ifndef TARGET_HAS_CLIC
+/**
+ * \brief Helper macro for creating fast machine mode handlers of individual interrupt causes
+ *
+ * - Switch to the stack saved for machine mode, if any, and save the caller-saved registers there.
+ * - Update the variable current privilege mode (bm_current_mode), and save the previous value.
+ * - Save the caller-saved floating point registers if their state is Dirty.
+ * - Call the user function registered for the cause directly, without decoding mcause.
+ * - Restore the saved state and exit the interrupt handler using mret.
+ */
+    #define CREATE_FAST_HANDLER(name, cause)                                        \
+        void __attribute__((naked, aligned(4))) name(void)                          \
+        {                                                                           \
+            __asm__ volatile("csrw mscratch, sp\n"                                  \
+                             TLS_ADDR("sp", "bm_priv_sp", "%0")                     \
+                             BM_LOAD " sp, 0 (sp)\n"                                \
+                             "bnez sp, 1f\n"                                        \
+                             "csrr sp, mscratch\n"                                  \
+                             "1:\n"                                                 \
+                             "addi sp, sp, -%1\n"                                   \
+                             BM_FAST_SAVE_REGS                                      \
+                             "csrr t0, mscratch\n"                                  \
+                             BM_STORE " t0, 16 * " BM_WORD_SIZE " (sp)\n"           \
+                             TLS_ADDR("t0", "bm_current_mode", "0")                 \
+                             "lw t1, 0 (t0)\n"                                      \
+                             BM_STORE " t1, 17 * " BM_WORD_SIZE " (sp)\n"           \
+                             "li t1, %2\n"                                          \
+                             "sw t1, 0 (t0)\n"                                      \
+                             BM_FAST_SAVE_FLOAT                                     \
+                             "la t0, %3\n"                                          \
+                             BM_LOAD " t0, 0 (t0)\n"                                \
+                             "bnez t0, 2f\n"                                        \
+                             "li a0, %4\n"                                          \
+                             "la t0, %5\n"                                          \
+                             "2:\n"                                                 \
+                             "jalr t0\n"                                            \
+                             BM_FAST_LOAD_FLOAT                                     \
+                             TLS_ADDR("t0", "bm_current_mode", "0")                 \
+                             BM_LOAD " t1, 17 * " BM_WORD_SIZE " (sp)\n"            \
+                             "sw t1, 0 (t0)\n"                                      \
+                             BM_FAST_LOAD_REGS                                      \
+                             BM_LOAD " sp, 16 * " BM_WORD_SIZE " (sp)\n"            \
+                             "mret\n"                                               \
+                             ::"i"(BM_PRIV_MODE_MACHINE * sizeof(xlen_t)),          \
+                             "i"(BM_FAST_FRAME_WORDS * sizeof(xlen_t)),             \
+                             "i"(BM_PRIV_MODE_MACHINE),                             \
+                             "i"(&bm_interrupt_handler_table[cause]),               \
+                             "i"(cause),                                            \
+                             "i"(bm_irq_handler_unset));                            \
+        }
+// clang-format on
+
+/**
+ * \brief Fast handlers of the machine mode interrupt causes
+ */
+CREATE_FAST_HANDLER(bm_fast_handler_msip, BM_INTERRUPT_MSIP)
+CREATE_FAST_HANDLER(bm_fast_handler_mtip, BM_INTERRUPT_MTIP)
+CREATE_FAST_HANDLER(bm_fast_handler_meip, BM_INTERRUPT_MEIP)
+
+/**
+ * \brief Machine mode vector table, exceptions and other causes go through the managed handler
+ */
+void __attribute__((naked, aligned(64))) bm_fast_vector_m(void)
+{
+    __asm__ volatile(".option push\n"
+                     ".option norvc\n"
+                     "j bm_managed_handler_m\n" // Exceptions
+                     "j bm_managed_handler_m\n"
+                     "j bm_managed_handler_m\n"
+                     "j bm_fast_handler_msip\n" // MSIP
+                     "j bm_managed_handler_m\n"
+                     "j bm_managed_handler_m\n"
+                     "j bm_managed_handler_m\n"
+                     "j bm_fast_handler_mtip\n" // MTIP
+                     "j bm_managed_handler_m\n"
+                     "j bm_managed_handler_m\n"
+                     "j bm_managed_handler_m\n"
+                     "j bm_fast_handler_meip\n" // MEIP
+                     "j bm_managed_handler_m\n"
+                     "j bm_managed_handler_m\n"
+                     "j bm_managed_handler_m\n"
+                     "j bm_managed_handler_m\n"
+                     ".option pop\n");
+}
+#else
+/** \brief Frame of the CLIC entry, the fast handler frame followed by mepc, mcause and padding */
+    #define BM_CLIC_FRAME_WORDS (BM_FAST_FRAME_WORDS + 4)
+
+/** \brief Vector table of the CLIC, handlers of non-vectored inputs are read from it through mnxti */
+static void (*bm_clic_mtvt[TARGET_CLIC_NUM_INPUTS])(void) __attribute__((aligned(64))) = {0};
+
+// Inputs whose vector table entry is a hardware vectored handler set by bm_clic_set_vector
+static bool bm_clic_shv[TARGET_CLIC_NUM_INPUTS];
+
+/**
+ * \brief Entry of the vector table for inputs without a handler
+ */
+static void bm_clic_handler_unset(void)
+{
+    bm_error("An interrupt with unset handler was triggered.");
+}
+
+// clang-format off
+/**
+ * \brief Machine mode CLIC trap entry with tail-chaining of non-vectored interrupts
+ *
+ * - Pass exceptions to the managed handler.
+ * - Switch to the stack saved for machine mode, if any and if not preempting a machine mode handler, and save
+ *   the caller-saved registers, mepc and mcause there.
+ * - Update the variable current privilege mode (bm_current_mode), and save the previous value.
+ * - Save the caller-saved floating point registers if their state is Dirty.
+ * - Claim the highest pending interrupt through mnxti, which also enables interrupts, so that interrupts of
+ *   a higher level preempt the handler. Call its handler from the vector table, and repeat while mnxti
+ *   returns another pending interrupt. Back-to-back interrupts are thus handled without restoring the
+ *   context in between.
+ * - Disable interrupts, restore the saved state and exit the interrupt handler using mret.
+ */
+void __attribute__((naked, aligned(64))) bm_clic_entry_m(void)
+{
+    __asm__ volatile("csrw mscratch, t0\n"
+                     "csrr t0, mcause\n"
+                     "bltz t0, 1f\n"
+                     "csrr t0, mscratch\n"
+                     "j bm_managed_handler_m\n"
+                     "1:\n"
+                     "csrr t0, mscratch\n"
+                     "csrw mscratch, sp\n"
+                     TLS_ADDR("sp", "bm_current_mode", "0")
+                     "lw sp, 0 (sp)\n"
+                     "addi sp, sp, -%2\n"
+                     "beqz sp, 7f\n" // Preempted machine mode handler keeps its stack
+                     TLS_ADDR("sp", "bm_priv_sp", "%0")
+                     BM_LOAD " sp, 0 (sp)\n"
+                     "bnez sp, 2f\n"
+                     "7:\n"
+                     "csrr sp, mscratch\n"
+                     "2:\n"
+                     "addi sp, sp, -%1\n"
+                     BM_FAST_SAVE_REGS
+                     "csrr t0, mscratch\n"
+                     BM_STORE " t0, 16 * " BM_WORD_SIZE " (sp)\n"
+                     "csrr t0, mepc\n"
+                     BM_STORE " t0, %3 (sp)\n"
+                     "csrr t0, mcause\n"
+                     BM_STORE " t0, %4 (sp)\n"
+                     TLS_ADDR("t0", "bm_current_mode", "0")
+                     "lw t1, 0 (t0)\n"
+                     BM_STORE " t1, 17 * " BM_WORD_SIZE " (sp)\n"
+                     "li t1, %2\n"
+                     "sw t1, 0 (t0)\n"
+                     BM_FAST_SAVE_FLOAT
+                     "csrrsi a0, %5, " BM_TO_STRING(BM_MSTATUS_MIE) "\n" // mnxti, sets mstatus.MIE
+                     "beqz a0, 6f\n"
+                     "5:\n"
+                     BM_LOAD " a0, 0 (a0)\n"
+                     "jalr a0\n"
+                     "csrrsi a0, %5, " BM_TO_STRING(BM_MSTATUS_MIE) "\n"
+                     "bnez a0, 5b\n"
+                     "6:\n"
+                     "csrci mstatus, " BM_TO_STRING(BM_MSTATUS_MIE) "\n"
+                     BM_FAST_LOAD_FLOAT
+                     TLS_ADDR("t0", "bm_current_mode", "0")
+                     BM_LOAD " t1, 17 * " BM_WORD_SIZE " (sp)\n"
+                     "sw t1, 0 (t0)\n"
+                     BM_LOAD " t0, %3 (sp)\n"
+                     "csrw mepc, t0\n"
+                     BM_LOAD " t0, %4 (sp)\n"
+                     "csrw mcause, t0\n"
+                     BM_FAST_LOAD_REGS
+                     BM_LOAD " sp, 16 * " BM_WORD_SIZE " (sp)\n"
+                     "mret\n"
+                     ::"i"(BM_PRIV_MODE_MACHINE * sizeof(xlen_t)),
+                     "i"(BM_CLIC_FRAME_WORDS * sizeof(xlen_t)),
+                     "i"(BM_PRIV_MODE_MACHINE),
+                     "i"(BM_FAST_FRAME_WORDS * sizeof(xlen_t)),
+                     "i"((BM_FAST_FRAME_WORDS + 1) * sizeof(xlen_t)),
+                     "i"(BM_CSR_MNXTI));
+}
+// clang-format on
+
+/**
+ * \brief Store a handler into the vector table and select hardware vectoring of the input
+ *
+ * \param clic_irq_id CLIC interrupt ID
+ * \param func Handler, NULL for the handler set by bm_interrupt_set_handler
+ * \param shv Jump to the handler directly
+ */
+static void bm_clic_set_vector(unsigned clic_irq_id, void (*func)(void), bool shv)
+{
+    bm_clic_t *clic = (bm_clic_t *)target_peripheral_get(BM_PERIPHERAL_CLIC);
+
+    bm_clic_mtvt[clic_irq_id] = func ? func : bm_clic_handler_unset;
+    bm_clic_shv[clic_irq_id]  = shv;
+
+    // The core fetches the vectored entries like instructions
+    bm_exec_fence_i();
+    bm_clic_set_vectored(clic, clic_irq_id, shv);
+}
+
+/**
+ * \brief Set the handler called by the common CLIC entry for an input
+ *
+ * The vector table entry of a hardware vectored input is kept, as the core would enter a plain C
+ * function without saving the registers. The handler is used once the vectoring is disabled.
+ *
+ * \param clic_irq_id CLIC interrupt ID
+ * \param func Handler
+ */
+static void bm_clic_set_handler(unsigned clic_irq_id, void (*func)(void))
+{
+    bm_interrupt_handler_table[clic_irq_id] = func;
+
+    if (!bm_clic_shv[clic_irq_id])
+    {
+        bm_clic_mtvt[clic_irq_id] = func ? func : bm_clic_handler_unset;
+    }
+}
 #endif
 
 void bm_interrupt_set_handler(bm_interrupt_source_t cause, void (*func)(void))
 {
 #ifdef TARGET_HAS_CLIC
-    bm_interrupt_handler_table[bm_clic_get_irq_id(cause)] = func;
+    bm_clic_set_handler(bm_clic_get_irq_id(cause), func);
 #else
     bm_interrupt_handler_table[cause]    = func;
 #endif
 }
 
+void bm_interrupt_set_shv_handler(bm_interrupt_source_t cause, void (*func)(void))
+{
+#ifdef TARGET_HAS_CLIC
+    unsigned clic_irq_id = bm_clic_get_irq_id(cause);
+
+    bm_clic_set_vector(clic_irq_id, func ? func : bm_interrupt_handler_table[clic_irq_id], func != NULL);
+#else
+    (void)cause;
+    (void)func;
+    bm_error("Hardware vectoring of individual interrupts requires CLIC.");
+#endif
+}
+
+void bm_ext_irq_set_shv_handler(unsigned ext_irq_id, void (*func)(void))
+{
+#ifdef TARGET_HAS_CLIC
+    unsigned clic_irq_id = bm_clic_get_ext_irq_id(ext_irq_id);
+
+    bm_clic_set_vector(clic_irq_id, func ? func : bm_interrupt_handler_table[clic_irq_id], func != NULL);
+#else
+    (void)ext_irq_id;
+    (void)func;
+    bm_error("Hardware vectoring of individual interrupts requires CLIC.");
+#endif
+}
+
 void bm_exception_set_handler(bm_exception_source_t cause, void (*func)(void))
 {
     bm_exc_handler_table[cause] = func;
@@ -419,7 +1138,7 @@ void bm_exception_set_handler(bm_exception_source_t cause, void (*func)(void))
 void bm_ext_irq_set_handler(unsigned ext_irq_id, void (*func)(void))
 {
 #ifdef TARGET_HAS_CLIC
-    bm_interrupt_handler_table[bm_clic_get_ext_irq_id(ext_irq_id)] = func;
+    bm_clic_set_handler(bm_clic_get_ext_irq_id(ext_irq_id), func);
 #else
     bm_ext_irq_handler_table[ext_irq_id] = func;
 #endif
@@ -448,6 +1167,10 @@ void bm_interrupt_init(bm_priv_mode_t priv_mode)
     }
     bm_interrupt_tvec_setup(priv_mode, handler, BM_INTERRUPT_MODE_DIRECT);
 
+#ifdef TARGET_HAS_PLIC
+    bm_plic_cache_init();
+#endif
+
 #ifndef TARGET_HAS_CLIC
     bm_interrupt_set_handler(BM_INTERRUPT_MEIP, bm_ext_irq_handler);
     #ifdef TARGET_EXT_S
@@ -462,6 +1185,43 @@ void bm_interrupt_init(bm_priv_mode_t priv_mode)
     bm_interrupt_enable(priv_mode);
 }
 
+void bm_interrupt_init_vectored(bm_priv_mode_t priv_mode)
+{
+    if (priv_mode != BM_PRIV_MODE_MACHINE)
+    {
+        bm_error("Unsupported privilege mode.");
+    }
+
+#ifdef TARGET_HAS_CLIC
+    for (unsigned i = 0; i < TARGET_CLIC_NUM_INPUTS; ++i)
+    {
+        if (!bm_clic_shv[i])
+        {
+            bm_clic_mtvt[i] = bm_interrupt_handler_table[i] ? bm_interrupt_handler_table[i] : bm_clic_handler_unset;
+        }
+    }
+
+    bm_csr_write(BM_CSR_MTVT, (xlen_t)bm_clic_mtvt);
+    bm_exec_fence_i();
+
+    // The mode bits are hardwired to the CLIC mode
+    bm_interrupt_tvec_setup(priv_mode, (xlen_t)bm_clic_entry_m, BM_INTERRUPT_MODE_DIRECT);
+
+    bm_interrupt_enable(priv_mode);
+#else
+
+    bm_interrupt_tvec_setup(priv_mode, (xlen_t)bm_fast_vector_m, BM_INTERRUPT_MODE_VECTOR);
+
+    #ifdef TARGET_HAS_PLIC
+    bm_plic_cache_init();
+    #endif
+    bm_interrupt_set_handler(BM_INTERRUPT_MEIP, bm_ext_irq_handler);
+
+    // Global enable for the given privilege mode, individual interrupt sources need to be enabled manually
+    bm_interrupt_enable(priv_mode);
+#endif
+}
+
 void bm_ext_irq_init(void)
 {
 #ifdef TARGET_HAS_CLIC
@@ -471,35 +1231,188 @@ void bm_ext_irq_init(void)
 }
 
 int bm_ext_irq_claim(void)
+{
+    return bm_ext_irq_claim_inline();
+}
+
+void bm_ext_irq_complete(unsigned ext_irq_id)
+{
+    bm_ext_irq_complete_inline(ext_irq_id);
+}
+
+void bm_ext_irq_set_budget(unsigned budget)
+{
+#ifdef TARGET_HAS_CLIC
+    (void)budget;
+#else
+    bm_ext_irq_budget = budget;
+#endif
+}
+
+void bm_ext_irq_get_stats(bm_ext_irq_stats_t *stats)
+{
+#ifdef TARGET_HAS_CLIC
+    *stats = (bm_ext_irq_stats_t){0};
+#else
+    *stats = bm_ext_irq_stats;
+#endif
+}
+
+void bm_ext_irq_reset_stats(void)
+{
+#ifndef TARGET_HAS_CLIC
+    bm_ext_irq_stats = (bm_ext_irq_stats_t){0};
+#endif
+}
+
+void bm_ext_irq_set_priority(unsigned ext_irq_id, unsigned priority)
 {
 #ifdef TARGET_HAS_PLIC
-    bm_plic_t *plic = (bm_plic_t *)target_peripheral_get(BM_PERIPHERAL_PLIC);
-    return bm_plic_claim(plic, bm_get_hartid());
+    bm_plic_set_priority(bm_plic_get(), ext_irq_id, priority);
+#elif defined(TARGET_HAS_CLIC)
+    bm_clic_t *clic = (bm_clic_t *)target_peripheral_get(BM_PERIPHERAL_CLIC);
+    bm_clic_set_level(clic, bm_clic_get_ext_irq_id(ext_irq_id), priority);
 #elif defined(TARGET_HAS_PIC)
-    return bm_pic_get_irq();
+    bm_pic_set_priority(ext_irq_id, priority);
 #else
-    return -1;
+    (void)ext_irq_id;
+    (void)priority;
 #endif
 }
 
-void bm_ext_irq_complete(unsigned ext_irq_id)
+void bm_ext_irq_set_threshold(unsigned threshold)
 {
 #ifdef TARGET_HAS_PLIC
-    bm_plic_t *plic = (bm_plic_t *)target_peripheral_get(BM_PERIPHERAL_PLIC);
-    bm_plic_complete(plic, bm_get_hartid(), ext_irq_id);
-#elif defined(TARGET_HAS_PIC)
-    bm_pic_clear_irq(ext_irq_id);
+    bm_plic_get_context()->THRESHOLD = threshold;
+#elif defined(TARGET_HAS_CLIC)
+    bm_csr_write(BM_CSR_MINTTHRESH, threshold);
+#else
+    (void)threshold;
+#endif
+}
+
+unsigned bm_ext_irq_get_threshold(void)
+{
+#ifdef TARGET_HAS_PLIC
+    return bm_plic_get_context()->THRESHOLD;
+#elif defined(TARGET_HAS_CLIC)
+    return bm_csr_read(BM_CSR_MINTTHRESH);
+#else
+    return 0;
+#endif
+}
+
+void bm_ext_irq_set_nested(bool nested)
+{
+#ifdef TARGET_HAS_CLIC
+    (void)nested;
+#else
+    bm_ext_irq_nested = nested;
+#endif
+}
+
+void bm_ext_irq_set_affinity(unsigned ext_irq_id, uint32_t hart_mask)
+{
+#ifdef TARGET_HAS_PLIC
+    hart_mask &= (uint32_t)((1ULL << TARGET_NUM_HARTS) - 1);
+    if (!hart_mask)
+    {
+        bm_error("External interrupt affinity must contain an existing hart.");
+    }
+
+    bm_mutex_lock(&bm_ext_irq_route_lock);
+
+    // Move the interrupt only if it is enabled somewhere
+    bool     enabled = false;
+    uint32_t old     = bm_ext_irq_affinity[ext_irq_id] ? bm_ext_irq_affinity[ext_irq_id] : 1UL << bm_get_hartid();
+
+    for (unsigned hart = 0; hart < TARGET_NUM_HARTS; ++hart)
+    {
+        enabled = enabled || bm_plic_get_enable(bm_plic_get(), hart, ext_irq_id);
+    }
+
+    bm_ext_irq_route(ext_irq_id, old, 0);
+
+    bm_ext_irq_affinity[ext_irq_id] = hart_mask;
+    bm_ext_irq_target[ext_irq_id]   = __builtin_ctz(hart_mask);
+
+    if (enabled)
+    {
+        if (bm_ext_irq_balance == BM_EXT_IRQ_BALANCE_NONE)
+        {
+            bm_ext_irq_route(ext_irq_id, hart_mask, 1);
+        }
+        else
+        {
+            bm_plic_set_enable(bm_plic_get(), bm_ext_irq_target[ext_irq_id], ext_irq_id, 1);
+        }
+    }
+
+    bm_mutex_unlock(&bm_ext_irq_route_lock);
 #else
     (void)ext_irq_id;
+    (void)hart_mask;
+#endif
+}
+
+void bm_ext_irq_set_balance(bm_ext_irq_balance_t mode)
+{
+#ifdef TARGET_HAS_PLIC
+    bm_mutex_lock(&bm_ext_irq_route_lock);
+
+    // Re-route the enabled interrupts with an affinity to all harts, or only to their current target
+    for (unsigned i = 0; i < BM_EXT_IRQ_NUM_SOURCES; ++i)
+    {
+        uint32_t mask   = bm_ext_irq_affinity[i];
+        unsigned target = bm_ext_irq_target[i];
+
+        if (!mask || !bm_plic_get_enable(bm_plic_get(), target, i))
+        {
+            continue;
+        }
+
+        bm_ext_irq_route(i, mask, 0);
+        if (mode == BM_EXT_IRQ_BALANCE_NONE)
+        {
+            bm_ext_irq_route(i, mask, 1);
+        }
+        else
+        {
+            bm_plic_set_enable(bm_plic_get(), target, i, 1);
+        }
+    }
+
+    bm_ext_irq_balance = mode;
+
+    bm_mutex_unlock(&bm_ext_irq_route_lock);
+#else
+    (void)mode;
 #endif
 }
 
 void bm_ext_irq_enable(unsigned ext_irq_id)
 {
 #ifdef TARGET_HAS_PLIC
-    bm_plic_t *plic = (bm_plic_t *)target_peripheral_get(BM_PERIPHERAL_PLIC);
-    bm_plic_set_enable(plic, bm_get_hartid(), ext_irq_id, 1);
-    bm_plic_set_priority(plic, ext_irq_id, 1);
+    bm_plic_t *plic = bm_plic_get();
+
+    if (!bm_ext_irq_affinity[ext_irq_id])
+    {
+        bm_plic_set_enable(plic, bm_get_hartid(), ext_irq_id, 1);
+    }
+    else if (bm_ext_irq_balance == BM_EXT_IRQ_BALANCE_NONE)
+    {
+        bm_ext_irq_route(ext_irq_id, bm_ext_irq_affinity[ext_irq_id], 1);
+    }
+    else
+    {
+        bm_plic_set_enable(plic, bm_ext_irq_target[ext_irq_id], ext_irq_id, 1);
+    }
+
+    // Keep the priority set by bm_ext_irq_set_priority
+    if (bm_plic_get_priority(plic, ext_irq_id) == 0)
+    {
+        bm_plic_set_priority(plic, ext_irq_id, 1);
+    }
 #elif defined(TARGET_HAS_CLIC)
     bm_clic_t *clic = (bm_clic_t *)target_peripheral_get(BM_PERIPHERAL_CLIC);
     bm_clic_set_enable(clic, bm_clic_get_ext_irq_id(ext_irq_id), 1);
@@ -513,8 +1426,14 @@ void bm_ext_irq_enable(unsigned ext_irq_id)
 void bm_ext_irq_disable(unsigned ext_irq_id)
 {
 #ifdef TARGET_HAS_PLIC
-    bm_plic_t *plic = (bm_plic_t *)target_peripheral_get(BM_PERIPHERAL_PLIC);
-    bm_plic_set_enable(plic, bm_get_hartid(), ext_irq_id, 0);
+    if (!bm_ext_irq_affinity[ext_irq_id])
+    {
+        bm_plic_set_enable(bm_plic_get(), bm_get_hartid(), ext_irq_id, 0);
+    }
+    else
+    {
+        bm_ext_irq_route(ext_irq_id, bm_ext_irq_affinity[ext_irq_id], 0);
+    }
 #elif defined(TARGET_HAS_CLIC)
     bm_clic_t *clic = (bm_clic_t *)target_peripheral_get(BM_PERIPHERAL_CLIC);
     bm_clic_set_enable(clic, bm_clic_get_ext_irq_id(ext_irq_id), 0);
@@ -0,0 +1,149 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include "baremetal/log.h"
+
+#include "baremetal/common.h"
+#include "baremetal/console.h"
+#include "baremetal/mutex.h"
+#include "baremetal/per_hart.h"
+#include "baremetal/platform.h"
+#include "baremetal/ringbuf.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+// Length of the longest emitted line: prefix, hart ID, header, arguments and the newline
+#define BM_LOG_LINE_SIZE (sizeof(BM_LOG_LINE_PREFIX) + 3 + (BM_LOG_MAX_ARGS + 1) * (2 * sizeof(xlen_t) + 1) + 1)
+
+BM_PER_HART bm_log_ring_t bm_log_ring;
+BM_PER_HART unsigned      bm_log_dropped;
+
+// Serializes the consumers of the log buffers
+static bm_mutex_t bm_log_lock = 0;
+
+// Number of dropped records already reported for each hart, bm_log_dropped is only written by the producers
+static unsigned bm_log_reported[TARGET_NUM_HARTS];
+
+/**
+ * \brief Append a value in hexadecimal to the line
+ *
+ * \param line Position in the line
+ * \param value Value to append
+ * \param digits Number of hexadecimal digits
+ *
+ * \return Position after the appended value
+ */
+static char *bm_log_put_hex(char *line, xlen_t value, unsigned digits)
+{
+    *line++ = ' ';
+
+    for (unsigned i = digits; i > 0; --i)
+    {
+        line[i - 1] = "0123456789abcdef"[value & 0xf];
+        value >>= 4;
+    }
+
+    return line + digits;
+}
+
+/**
+ * \brief Emit a line with the prefix, hart ID and given words
+ *
+ * \param hart_id ID of the hart whose record is emitted
+ * \param words Words of the record
+ * \param count Number of the words
+ */
+static void bm_log_emit(unsigned hart_id, const xlen_t *words, size_t count)
+{
+    char  line[BM_LOG_LINE_SIZE] = BM_LOG_LINE_PREFIX;
+    char *pos                    = line + sizeof(BM_LOG_LINE_PREFIX) - 1;
+
+    pos = bm_log_put_hex(pos, hart_id, 2);
+    for (size_t i = 0; i < count; ++i)
+    {
+        pos = bm_log_put_hex(pos, words[i], 2 * sizeof(xlen_t));
+    }
+    *pos++ = '\n';
+
+    bm_console_write(STDOUT_FILENO, line, pos - line);
+}
+
+/**
+ * \brief Emit records from the log buffer of given hart, the caller holds the lock
+ *
+ * \param hart_id ID of the hart
+ * \param max_records Maximum number of records to emit
+ *
+ * \return Number of records emitted
+ */
+static unsigned bm_log_drain_hart(unsigned hart_id, unsigned max_records)
+{
+    bm_log_ring_t *ring    = &bm_of_hart(bm_log_ring, hart_id);
+    unsigned      *dropped = &bm_of_hart(bm_log_dropped, hart_id);
+    unsigned       count   = 0;
+
+    // The records are pushed whole, so a visible header means the whole record is available
+    while (count < max_records && !bm_ringbuf_empty(ring))
+    {
+        xlen_t words[BM_LOG_MAX_ARGS + 1];
+
+        bm_ringbuf_pop(ring, &words[0], sizeof(xlen_t));
+
+        size_t num_args = words[0] & BM_LOG_MAX_ARGS;
+        bm_ringbuf_pop(ring, &words[1], num_args * sizeof(xlen_t));
+
+        bm_log_emit(hart_id, words, num_args + 1);
+        count++;
+    }
+
+    // Records lost due to a full buffer are reported by a record with a null format string
+    unsigned lost = *dropped - bm_log_reported[hart_id];
+    if (lost)
+    {
+        xlen_t words[2] = {1, lost};
+        bm_log_reported[hart_id] += lost;
+        bm_log_emit(hart_id, words, 2);
+    }
+
+    return count;
+}
+
+void bm_log_init(void)
+{
+    bm_console_set_exit_hook(bm_log_flush);
+}
+
+unsigned bm_log_drain(unsigned max_records)
+{
+    unsigned count = 0;
+
+    if (bm_mutex_trylock(&bm_log_lock))
+    {
+        return 0;
+    }
+
+    for (unsigned i = 0; i < TARGET_NUM_HARTS && count < max_records; ++i)
+    {
+        count += bm_log_drain_hart(i, max_records - count);
+    }
+
+    bm_mutex_unlock(&bm_log_lock);
+
+    return count;
+}
+
+void bm_log_flush(void)
+{
+    bm_mutex_lock(&bm_log_lock);
+
+    for (unsigned i = 0; i < TARGET_NUM_HARTS; ++i)
+    {
+        bm_log_drain_hart(i, UINT32_MAX);
+    }
+
+    bm_mutex_unlock(&bm_log_lock);
+
+    bm_console_flush();
+}
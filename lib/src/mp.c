@@ -3,8 +3,18 @@
 
 #include "baremetal/mp.h"
 
+#include "baremetal/common.h"
 #include "baremetal/csr.h"
+#include "baremetal/interrupt_low.h"
 #include "baremetal/mem_barrier.h"
+#include "baremetal/mutex.h"
+#include "baremetal/per_hart.h"
+#include "baremetal/verbose.h"
+
+#ifdef TARGET_HAS_CLINT
+    #include "baremetal/clint.h"
+    #include "baremetal/platform.h"
+#endif
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -16,65 +26,223 @@ typedef struct {
     bool               ready;
 } bm_hart_sync_data_t;
 
-// Shared data for synchronization between harts
-static volatile bm_hart_sync_data_t bm_hart_sync_data[TARGET_NUM_HARTS];
+// Data for synchronization between harts, each hart polls only its own copy
+static BM_PER_HART volatile bm_hart_sync_data_t bm_hart_sync_data;
+
+// Taken by bm_hart_start until the job finishes, so that concurrent callers cannot assign two jobs to a hart.
+// The main hart runs the application and accepts jobs only while it waits in bm_hart_join.
+static bm_mutex_t bm_hart_claim[TARGET_NUM_HARTS] = {1};
+
+// The main hart waits in bm_hart_join, a nested call from a job executed meanwhile does not accept jobs
+static bool bm_main_hart_joining = false;
+
+// Placed first in the per-hart data, so that it is accessible with a single tp-relative load
+USED __attribute__((section(".tdata.bm_hartid"))) BM_PER_HART unsigned bm_current_hartid = 0;
+
+#ifdef TARGET_HAS_CLINT
+static volatile bm_hart_park_mode_t bm_hart_park_mode = BM_HART_PARK_WFI;
+
+/**
+ * \brief Sleep in WFI until the hart is assigned a job
+ *
+ * Interrupts are globally masked while waiting, so that an IPI arriving between the check of the
+ * ready flag and WFI is not lost. WFI wakes up on any pending enabled interrupt regardless of the mask.
+ * If interrupts were enabled before, a short window lets the user handlers service their sources.
+ *
+ * \param clint CLINT device
+ * \param hart_id ID of the current hart
+ */
+static void bm_hart_wait_wfi(bm_clint_t *clint, unsigned hart_id)
+{
+    volatile bm_hart_sync_data_t *sync_data = &bm_hart_sync_data;
+    const xlen_t mstatus_mie = BM_MSTATUS_MIE;
+    const xlen_t mie_msip    = (xlen_t)1 << BM_INTERRUPT_MSIP;
+    xlen_t       mstatus, mie;
+
+    CSR_READ(BM_CSR_MSTATUS, mstatus);
+    CSR_READ(BM_CSR_MIE, mie);
+    CSR_CLEAR(BM_CSR_MSTATUS, mstatus_mie);
+    CSR_SET(BM_CSR_MIE, mie_msip);
+
+    while (!sync_data->ready)
+    {
+        bm_wfi();
+
+        if (sync_data->ready)
+        {
+            break;
+        }
+
+        if (!(mie & mie_msip))
+        {
+            // Software interrupts are not used by the application, drop the stray IPI
+            bm_clint_clear_ipi(clint, hart_id);
+        }
+
+        if (mstatus & mstatus_mie)
+        {
+            // Let the configured handlers service the pending interrupts
+            CSR_SET(BM_CSR_MSTATUS, mstatus_mie);
+            CSR_CLEAR(BM_CSR_MSTATUS, mstatus_mie);
+        }
+    }
+
+    // Acknowledge the wakeup IPI and restore the original interrupt configuration
+    bm_clint_clear_ipi(clint, hart_id);
+
+    if (!(mie & mie_msip))
+    {
+        CSR_CLEAR(BM_CSR_MIE, mie_msip);
+    }
+    CSR_SET(BM_CSR_MSTATUS, mstatus & mstatus_mie);
+}
+#else
+static volatile bm_hart_park_mode_t bm_hart_park_mode = BM_HART_PARK_SPIN;
+#endif
+
+/**
+ * \brief Execute the job assigned to the current hart and report it as finished
+ *
+ * \param sync_data Sync data of the current hart
+ */
+static void bm_hart_run_job(volatile bm_hart_sync_data_t *sync_data)
+{
+    bm_exec_fence();
+
+    // Fetch the jobs data and execute it
+    bm_hart_func_arg_t arg  = sync_data->arg;
+    bm_hart_func_ptr_t func = sync_data->func;
+
+    func(arg);
+
+    // Make the results of the job visible before it is reported as finished
+    bm_exec_fence();
+
+    // Clear the ready flag to signal the job is finished
+    sync_data->ready = false;
+}
 
 /**
  * \brief Routine called from the startup assembly to manage non-main harts
  */
 void __attribute__((noreturn, used)) bm_park_hart(void)
 {
-    unsigned hart_id = bm_get_hartid();
+    volatile bm_hart_sync_data_t *sync_data = &bm_hart_sync_data;
+
+#ifdef TARGET_HAS_CLINT
+    unsigned    hart_id = bm_get_hartid();
+    bm_clint_t *clint   = (bm_clint_t *)target_peripheral_get(BM_PERIPHERAL_CLINT);
+#endif
 
     // All harts except the main one loop here when inactive
     while (true)
     {
         // Wait until the hart is assigned a job
-        while (!bm_hart_sync_data[hart_id].ready)
+#ifdef TARGET_HAS_CLINT
+        if (bm_hart_park_mode == BM_HART_PARK_WFI)
+        {
+            bm_hart_wait_wfi(clint, hart_id);
+        }
+#endif
+        while (!sync_data->ready)
             ;
 
-        bm_exec_fence();
-
-        // Fetch the jobs data and execute it
-        bm_hart_func_arg_t arg  = bm_hart_sync_data[hart_id].arg;
-        bm_hart_func_ptr_t func = bm_hart_sync_data[hart_id].func;
-
-        func(arg);
-
-        // Clear the ready flag to signal the job is finished
-        bm_hart_sync_data[hart_id].ready = false;
+        bm_hart_run_job(sync_data);
+        bm_mutex_unlock(&bm_hart_claim[bm_get_hartid()]);
     }
 }
 
 int bm_hart_start(unsigned hart_id, bm_hart_func_ptr_t func, bm_hart_func_arg_t arg)
 {
-    if (bm_hart_sync_data[hart_id].ready)
+    volatile bm_hart_sync_data_t *sync_data = &bm_of_hart(bm_hart_sync_data, hart_id);
+
+    if (bm_mutex_trylock(&bm_hart_claim[hart_id]))
     {
-        // Hart is already running a job
+        // Hart is already running a job, or it is the main hart busy with the application
         return -1;
     }
 
     // Configure parameters for the other hart
-    bm_hart_sync_data[hart_id].arg  = arg;
-    bm_hart_sync_data[hart_id].func = func;
+    sync_data->arg  = arg;
+    sync_data->func = func;
 
     bm_exec_fence();
 
     // Instruct the other hart to start the execution
-    bm_hart_sync_data[hart_id].ready = true;
+    sync_data->ready = true;
+
+#ifdef TARGET_HAS_CLINT
+    // Wake the hart up in case it sleeps in WFI, the IPI is cleared by the hart itself. The main
+    // hart polls in bm_hart_join instead.
+    if (hart_id != 0)
+    {
+        bm_exec_fence();
+        bm_clint_send_ipi((bm_clint_t *)target_peripheral_get(BM_PERIPHERAL_CLINT), hart_id);
+    }
+#endif
 
     return 0;
 }
 
+void bm_hart_set_park_mode(bm_hart_park_mode_t mode)
+{
+#ifndef TARGET_HAS_CLINT
+    if (mode == BM_HART_PARK_WFI)
+    {
+        bm_warn("WFI parking requires CLINT, keeping spin mode.");
+        return;
+    }
+#endif
+
+    bm_hart_park_mode = mode;
+    bm_exec_fence();
+}
+
+bm_hart_park_mode_t bm_hart_get_park_mode(void)
+{
+    return bm_hart_park_mode;
+}
+
 bool bm_hart_running(unsigned hart_id)
 {
-    return bm_hart_sync_data[hart_id].ready;
+    return bm_of_hart(bm_hart_sync_data, hart_id).ready;
 }
 
 void bm_hart_join(unsigned hart_id)
 {
+    volatile bm_hart_sync_data_t *sync_data = &bm_hart_sync_data;
+
+    if (bm_get_hartid() != 0 || bm_main_hart_joining)
+    {
+        while (bm_hart_running(hart_id))
+            ;
+        return;
+    }
+
+    bm_main_hart_joining = true;
+
+    // While waiting, the main hart executes jobs of other harts, e.g. of a parallel loop started by the joined hart
+    bm_mutex_unlock(&bm_hart_claim[0]);
+
     while (bm_hart_running(hart_id))
-        ;
+    {
+        if (sync_data->ready)
+        {
+            bm_hart_run_job(sync_data);
+            bm_mutex_unlock(&bm_hart_claim[0]);
+        }
+    }
+
+    // Stop accepting jobs, a job assigned meanwhile is executed first
+    if (bm_mutex_trylock(&bm_hart_claim[0]))
+    {
+        while (!sync_data->ready)
+            ;
+
+        bm_hart_run_job(sync_data);
+    }
+
+    bm_main_hart_joining = false;
 }
 
 void bm_hart_execute_all(bm_hart_func_ptr_t func)
@@ -94,8 +262,3 @@ void bm_hart_execute_all(bm_hart_func_ptr_t func)
         bm_hart_join(i);
     }
 }
-
-unsigned bm_get_hartid(void)
-{
-    return (unsigned)bm_csr_read(BM_CSR_MHARTID);
-}
@@ -0,0 +1,305 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include "baremetal/parallel.h"
+
+#include "baremetal/common.h"
+#include "baremetal/mem_barrier.h"
+#include "baremetal/mp.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of dynamic chunks per worker used when no grain is given
+#define BM_PARALLEL_DYNAMIC_SPLIT 8
+
+static bm_parallel_schedule_t bm_parallel_schedule = BM_PARALLEL_SCHEDULE_STATIC;
+
+void bm_parallel_set_schedule(bm_parallel_schedule_t schedule)
+{
+    bm_parallel_schedule = schedule;
+}
+
+bm_parallel_schedule_t bm_parallel_get_schedule(void)
+{
+    return bm_parallel_schedule;
+}
+
+#if TARGET_NUM_HARTS == 1
+void bm_parallel_for(size_t begin, size_t end, size_t grain UNUSED, bm_parallel_for_func_t func, void *ctx)
+{
+    if (begin < end)
+    {
+        func(begin, end, ctx);
+    }
+}
+
+uint64_t bm_parallel_reduce(size_t                     begin,
+                            size_t                     end,
+                            size_t                     grain UNUSED,
+                            bm_parallel_reduce_func_t  func,
+                            bm_parallel_combine_func_t combine,
+                            uint64_t                   identity,
+                            void                      *ctx)
+{
+    if (begin >= end)
+    {
+        return identity;
+    }
+
+    return combine(identity, func(begin, end, identity, ctx));
+}
+#elif !defined(__riscv_atomic)
+    #error "Systems with multiple harts and no atomic instructions are not supported"
+#else
+
+/** \brief Description of a parallel loop shared by all participating harts */
+typedef struct {
+    // Counter of the next chunk to process in dynamic mode, kept in its own cache line
+    volatile uint32_t next_chunk __attribute__((aligned(BM_CACHE_LINE_SIZE)));
+
+    // Read-only parameters of the loop
+    size_t                    begin __attribute__((aligned(BM_CACHE_LINE_SIZE)));
+    size_t                    end;
+    size_t                    grain;
+    uint32_t                  num_chunks;
+    unsigned                  num_workers;
+    bm_parallel_schedule_t    schedule;
+    bm_parallel_for_func_t    for_func;
+    bm_parallel_reduce_func_t reduce_func;
+    uint64_t                  identity;
+    void                     *ctx;
+} bm_parallel_job_t;
+
+/** \brief Per-worker data, padded to a cache line to avoid false sharing of partial results */
+typedef struct {
+    bm_parallel_job_t *job;
+    unsigned           index;
+    uint64_t           result;
+} __attribute__((aligned(BM_CACHE_LINE_SIZE))) bm_parallel_worker_t;
+
+/**
+ * \brief Atomically fetch the next chunk index
+ *
+ * \param job Job to fetch the chunk from
+ *
+ * \return Index of the chunk to be processed by the caller
+ */
+static inline uint32_t bm_parallel_fetch_chunk(bm_parallel_job_t *job)
+{
+    uint32_t chunk;
+    uint32_t tmp = 1;
+
+    __asm__ volatile("amoadd.w %0, %1, (%2)\n" : "=r"(chunk) : "r"(tmp), "r"(&job->next_chunk) : "memory");
+
+    return chunk;
+}
+
+/**
+ * \brief Process one chunk of the job
+ *
+ * \param job Job to process
+ * \param chunk Index of the chunk
+ * \param acc Partial result accumulated so far
+ *
+ * \return Updated partial result
+ */
+static uint64_t bm_parallel_process_chunk(bm_parallel_job_t *job, uint32_t chunk, uint64_t acc)
+{
+    size_t begin = job->begin + (size_t)chunk * job->grain;
+    size_t end   = (job->end - begin > job->grain) ? begin + job->grain : job->end;
+
+    if (job->reduce_func)
+    {
+        return job->reduce_func(begin, end, acc, job->ctx);
+    }
+
+    job->for_func(begin, end, job->ctx);
+    return acc;
+}
+
+/**
+ * \brief Process all chunks belonging to a worker
+ *
+ * \param job Job to process
+ * \param index Index of the worker
+ *
+ * \return Partial result of the worker
+ */
+static uint64_t bm_parallel_run(bm_parallel_job_t *job, unsigned index)
+{
+    uint64_t acc = job->identity;
+
+    if (job->schedule == BM_PARALLEL_SCHEDULE_DYNAMIC)
+    {
+        uint32_t chunk;
+        while ((chunk = bm_parallel_fetch_chunk(job)) < job->num_chunks)
+        {
+            acc = bm_parallel_process_chunk(job, chunk, acc);
+        }
+    }
+    else
+    {
+        for (uint32_t chunk = index; chunk < job->num_chunks; chunk += job->num_workers)
+        {
+            acc = bm_parallel_process_chunk(job, chunk, acc);
+        }
+    }
+
+    return acc;
+}
+
+/**
+ * \brief Entry point of the worker harts
+ */
+static void bm_parallel_worker(bm_hart_func_arg_t arg)
+{
+    bm_parallel_worker_t *worker = (bm_parallel_worker_t *)arg;
+
+    worker->result = bm_parallel_run(worker->job, worker->index);
+
+    // Publish the partial result before the hart is marked as available
+    bm_exec_fence();
+}
+
+/**
+ * \brief Distribute the job among available harts and wait for its completion
+ *
+ * \param job Job with the loop parameters filled in
+ * \param combine Function combining partial results, NULL for loops without result
+ *
+ * \return Combined result
+ */
+static uint64_t bm_parallel_execute(bm_parallel_job_t *job, bm_parallel_combine_func_t combine)
+{
+    bm_parallel_worker_t workers[TARGET_NUM_HARTS];
+    unsigned             harts[TARGET_NUM_HARTS];
+    bool                 started[TARGET_NUM_HARTS];
+    unsigned             self        = bm_get_hartid();
+    unsigned             num_workers = 1;
+    size_t               count       = job->end - job->begin;
+
+    // The calling hart is always worker 0, idle harts join as further workers. The main hart is only
+    // idle while it waits in bm_hart_join, otherwise its chunks are processed by the calling hart.
+    for (unsigned i = 0; i < TARGET_NUM_HARTS; ++i)
+    {
+        if (i != self && !bm_hart_running(i))
+        {
+            harts[num_workers++] = i;
+        }
+    }
+
+    if (job->grain == 0)
+    {
+        job->grain = (count + num_workers - 1) / num_workers;
+        if (job->schedule == BM_PARALLEL_SCHEDULE_DYNAMIC)
+        {
+            job->grain = (job->grain + BM_PARALLEL_DYNAMIC_SPLIT - 1) / BM_PARALLEL_DYNAMIC_SPLIT;
+        }
+    }
+
+    // The chunk counter is 32-bit wide, enlarge the grain for huge ranges
+    if ((count - 1) / job->grain >= UINT32_MAX)
+    {
+        job->grain = (count + UINT32_MAX - 1) / UINT32_MAX;
+    }
+
+    job->num_chunks  = (uint32_t)((count + job->grain - 1) / job->grain);
+    job->num_workers = num_workers;
+    job->next_chunk  = 0;
+
+    for (unsigned i = 0; i < num_workers; ++i)
+    {
+        workers[i].job    = job;
+        workers[i].index  = i;
+        workers[i].result = job->identity;
+    }
+
+    // Ensure the job is visible from all harts before starting them
+    bm_exec_fence();
+
+    for (unsigned i = 1; i < num_workers; ++i)
+    {
+        started[i] = bm_hart_start(harts[i], bm_parallel_worker, &workers[i]) == 0;
+    }
+
+    workers[0].result = bm_parallel_run(job, 0);
+
+    // Statically assigned chunks of harts which got busy meanwhile are processed here
+    for (unsigned i = 1; i < num_workers; ++i)
+    {
+        if (!started[i])
+        {
+            workers[i].result = bm_parallel_run(job, i);
+        }
+    }
+
+    uint64_t result = job->identity;
+
+    for (unsigned i = 0; i < num_workers; ++i)
+    {
+        if (i > 0 && started[i])
+        {
+            bm_hart_join(harts[i]);
+        }
+
+        bm_exec_fence();
+
+        if (combine)
+        {
+            result = combine(result, workers[i].result);
+        }
+    }
+
+    return result;
+}
+
+void bm_parallel_for(size_t begin, size_t end, size_t grain, bm_parallel_for_func_t func, void *ctx)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    bm_parallel_job_t job = {
+        .begin       = begin,
+        .end         = end,
+        .grain       = grain,
+        .schedule    = bm_parallel_schedule,
+        .for_func    = func,
+        .reduce_func = NULL,
+        .identity    = 0,
+        .ctx         = ctx,
+    };
+
+    bm_parallel_execute(&job, NULL);
+}
+
+uint64_t bm_parallel_reduce(size_t                     begin,
+                            size_t                     end,
+                            size_t                     grain,
+                            bm_parallel_reduce_func_t  func,
+                            bm_parallel_combine_func_t combine,
+                            uint64_t                   identity,
+                            void                      *ctx)
+{
+    if (begin >= end)
+    {
+        return identity;
+    }
+
+    bm_parallel_job_t job = {
+        .begin       = begin,
+        .end         = end,
+        .grain       = grain,
+        .schedule    = bm_parallel_schedule,
+        .for_func    = NULL,
+        .reduce_func = func,
+        .identity    = identity,
+        .ctx         = ctx,
+    };
+
+    return bm_parallel_execute(&job, combine);
+}
+#endif
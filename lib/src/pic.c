@@ -6,6 +6,7 @@
 #include "baremetal/csr.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #define PIC_REG_WIDTH 32
 #define PIC_REG_MASK  0xffffffff
@@ -28,6 +29,67 @@ const bm_csr_id mpicflag_table[] = {
     BM_CSR_MPICFLAG3,
 };
 
+/** \brief Sources assigned to each software priority level, level 0 holds no explicit mask */
+static uint32_t bm_pic_priority_masks[BM_PIC_NUM_PRIORITIES][PIC_NUM_REGS];
+
+/** \brief Highest priority level with at least one source assigned */
+static unsigned bm_pic_max_priority = 0;
+
+/**
+ * \brief Read pending and enabled sources of one PIC register directly, without the generic CSR switch
+ *
+ * \param flag_csr ID of the flag CSR, must be a compile-time constant
+ * \param mask_csr ID of the mask CSR, must be a compile-time constant
+ * \param pending Variable receiving the pending and enabled sources
+ */
+#define PIC_READ_PENDING(flag_csr, mask_csr, pending) \
+    do                                                \
+    {                                                 \
+        xlen_t flag, mask;                            \
+        CSR_READ(flag_csr, flag);                     \
+        CSR_READ(mask_csr, mask);                     \
+        (pending) = (uint32_t)(flag & mask);          \
+    } while (0)
+
+/**
+ * \brief Count trailing zeros of a non-zero word
+ *
+ * With Zbb the compiler emits a single ctz instruction, otherwise a de Bruijn multiplication
+ * avoids the library call which __builtin_ctz expands to.
+ */
+static inline unsigned bm_pic_ctz(uint32_t value)
+{
+#ifdef __riscv_zbb
+    return __builtin_ctz(value);
+#else
+    static const uint8_t debruijn_table[32] = {
+        0,  1,  28, 2,  29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4,  8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6,  11, 5,  10, 9,
+    };
+
+    return debruijn_table[((value & -value) * 0x077cb531u) >> 27];
+#endif
+}
+
+/**
+ * \brief Read pending and enabled sources of all PIC registers
+ *
+ * \param pending Array receiving one word per PIC register
+ */
+static inline void bm_pic_read_pending(uint32_t pending[PIC_NUM_REGS])
+{
+    PIC_READ_PENDING(BM_CSR_MPICFLAG, BM_CSR_MPICMASK, pending[0]);
+#if TARGET_PIC_NUM_INTERRUPTS > 32
+    PIC_READ_PENDING(BM_CSR_MPICFLAG1, BM_CSR_MPICMASK1, pending[1]);
+#endif
+#if TARGET_PIC_NUM_INTERRUPTS > 64
+    PIC_READ_PENDING(BM_CSR_MPICFLAG2, BM_CSR_MPICMASK2, pending[2]);
+#endif
+#if TARGET_PIC_NUM_INTERRUPTS > 96
+    PIC_READ_PENDING(BM_CSR_MPICFLAG3, BM_CSR_MPICMASK3, pending[3]);
+#endif
+}
+
 void bm_pic_enable_source(unsigned ext_irq_id)
 {
     unsigned reg_index  = ext_irq_id / PIC_REG_WIDTH;
@@ -62,29 +124,130 @@ void bm_pic_disable_all(void)
 
 void bm_pic_clear_irq(unsigned bit)
 {
-    unsigned reg_index  = bit / PIC_REG_WIDTH;
-    unsigned reg_offset = bit % PIC_REG_WIDTH;
+    xlen_t mask = 1UL << (bit % PIC_REG_WIDTH);
 
-    bm_csr_clear_mask(mpicflag_table[reg_index], 1UL << reg_offset);
+    switch (bit / PIC_REG_WIDTH)
+    {
+        case 0:
+            CSR_CLEAR(BM_CSR_MPICFLAG, mask);
+            break;
+#if TARGET_PIC_NUM_INTERRUPTS > 32
+        case 1:
+            CSR_CLEAR(BM_CSR_MPICFLAG1, mask);
+            break;
+#endif
+#if TARGET_PIC_NUM_INTERRUPTS > 64
+        case 2:
+            CSR_CLEAR(BM_CSR_MPICFLAG2, mask);
+            break;
+#endif
+#if TARGET_PIC_NUM_INTERRUPTS > 96
+        case 3:
+            CSR_CLEAR(BM_CSR_MPICFLAG3, mask);
+            break;
+#endif
+        default:
+            break;
+    }
 }
 
 int bm_pic_get_irq(void)
 {
-    for (int i = 0; i < PIC_NUM_REGS; ++i)
+    uint32_t pending;
+
+    PIC_READ_PENDING(BM_CSR_MPICFLAG, BM_CSR_MPICMASK, pending);
+    if (pending)
+    {
+        return bm_pic_ctz(pending);
+    }
+#if TARGET_PIC_NUM_INTERRUPTS > 32
+    PIC_READ_PENDING(BM_CSR_MPICFLAG1, BM_CSR_MPICMASK1, pending);
+    if (pending)
+    {
+        return 32 + bm_pic_ctz(pending);
+    }
+#endif
+#if TARGET_PIC_NUM_INTERRUPTS > 64
+    PIC_READ_PENDING(BM_CSR_MPICFLAG2, BM_CSR_MPICMASK2, pending);
+    if (pending)
+    {
+        return 64 + bm_pic_ctz(pending);
+    }
+#endif
+#if TARGET_PIC_NUM_INTERRUPTS > 96
+    PIC_READ_PENDING(BM_CSR_MPICFLAG3, BM_CSR_MPICMASK3, pending);
+    if (pending)
+    {
+        return 96 + bm_pic_ctz(pending);
+    }
+#endif
+
+    return -1;
+}
+
+void bm_pic_set_priority(unsigned ext_irq_id, unsigned priority)
+{
+    unsigned reg_index  = ext_irq_id / PIC_REG_WIDTH;
+    uint32_t reg_offset = 1UL << (ext_irq_id % PIC_REG_WIDTH);
+
+    if (priority >= BM_PIC_NUM_PRIORITIES)
+    {
+        priority = BM_PIC_NUM_PRIORITIES - 1;
+    }
+
+    for (unsigned level = 1; level < BM_PIC_NUM_PRIORITIES; ++level)
+    {
+        bm_pic_priority_masks[level][reg_index] &= ~reg_offset;
+    }
+
+    if (priority > 0)
+    {
+        bm_pic_priority_masks[priority][reg_index] |= reg_offset;
+    }
+
+    // Recompute the highest used level so that the lookup skips the empty ones
+    bm_pic_max_priority = 0;
+    for (unsigned level = 1; level < BM_PIC_NUM_PRIORITIES; ++level)
+    {
+        for (unsigned i = 0; i < PIC_NUM_REGS; ++i)
+        {
+            if (bm_pic_priority_masks[level][i])
+            {
+                bm_pic_max_priority = level;
+            }
+        }
+    }
+}
+
+int bm_pic_get_irq_by_priority(void)
+{
+    if (bm_pic_max_priority == 0)
+    {
+        return bm_pic_get_irq();
+    }
+
+    uint32_t pending[PIC_NUM_REGS];
+
+    bm_pic_read_pending(pending);
+
+    for (unsigned level = bm_pic_max_priority; level > 0; --level)
     {
-        xlen_t enabled = bm_csr_read(mpicflag_table[i]) & bm_csr_read(mpicmask_table[i]);
-        if (!enabled)
+        for (unsigned i = 0; i < PIC_NUM_REGS; ++i)
         {
-            continue;
+            uint32_t bits = pending[i] & bm_pic_priority_masks[level][i];
+            if (bits)
+            {
+                return i * PIC_REG_WIDTH + bm_pic_ctz(bits);
+            }
         }
+    }
 
-        unsigned lsb = i * PIC_REG_WIDTH;
-        while (!(enabled & 1))
+    for (unsigned i = 0; i < PIC_NUM_REGS; ++i)
+    {
+        if (pending[i])
         {
-            enabled >>= 1;
-            ++lsb;
+            return i * PIC_REG_WIDTH + bm_pic_ctz(pending[i]);
         }
-        return lsb;
     }
 
     return -1;
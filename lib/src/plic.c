@@ -98,3 +98,9 @@ void bm_plic_complete(bm_plic_t *plic, unsigned context, unsigned ext_irq_id)
 {
     plic->regs->CONTEXT[context].COMPLETE = ext_irq_id + 1;
 }
+
+bm_plic_context_regs_t *bm_plic_get_context_regs(bm_plic_t *plic, unsigned context)
+{
+    // The context structure starts with the THRESHOLD and CLAIM/COMPLETE registers
+    return (bm_plic_context_regs_t *)&plic->regs->CONTEXT[context];
+}
@@ -32,6 +32,9 @@
 
 #include "tiny_printf/printf.h"
 
+#include "baremetal/console.h"
+
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <unistd.h>
@@ -75,6 +78,16 @@
     #define PRINTF_SUPPORT_LONG_LONG
 #endif
 
+// support for the floating point types (%f, %F, %e, %E, %g, %G) is enabled by
+// defining PRINTF_SUPPORT_FLOAT and PRINTF_SUPPORT_EXPONENTIAL, which is done
+// by the CONFIG_PRINTF_PROFILE=FULL build profile
+// default: deactivated
+
+// the decimal conversion writes up to 20 digits of a 64-bit value at once
+#if PRINTF_NTOA_BUFFER_SIZE < 20U
+    #error PRINTF_NTOA_BUFFER_SIZE must hold the 20 decimal digits of a 64-bit value
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 
 // internal flag definitions
@@ -214,6 +227,47 @@ static size_t _out_rev(out_fct_type out,
     return idx;
 }
 
+// pairs of decimal digits from 00 to 99, two digits are converted per division
+static const char _dec_pairs[200] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+// internal decimal conversion, writes the digits in reverse order and pads them
+// with zeros to min_digits, returns the new length of the buffer
+// the division by the constant 100 is compiled into a multiplication by its reciprocal
+static size_t _dec_rev(char *buf, size_t len, unsigned long value, size_t min_digits)
+{
+    const size_t start_len = len;
+
+    while (value >= 100U)
+    {
+        const unsigned int pair = (unsigned int)(value % 100U) * 2U;
+        value /= 100U;
+        buf[len++] = _dec_pairs[pair + 1U];
+        buf[len++] = _dec_pairs[pair];
+    }
+
+    if (value >= 10U)
+    {
+        buf[len++] = _dec_pairs[value * 2U + 1U];
+        buf[len++] = _dec_pairs[value * 2U];
+    }
+    else
+    {
+        buf[len++] = (char)('0' + value);
+    }
+
+    while (len - start_len < min_digits)
+    {
+        buf[len++] = '0';
+    }
+
+    return len;
+}
+
 // internal itoa format
 static size_t _ntoa_format(out_fct_type out,
                            char        *buffer,
@@ -316,12 +370,21 @@ static size_t _ntoa_long(out_fct_type  out,
     // write if precision != 0 and value is != 0
     if (!(flags & FLAGS_PRECISION) || value)
     {
-        do
+        if (base == 10U)
+        {
+            len = _dec_rev(buf, 0U, value, 0U);
+        }
+        else
         {
-            const char digit = (char)(value % base);
-            buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
-            value /= base;
-        } while (value && (len < PRINTF_NTOA_BUFFER_SIZE));
+            // the other bases are powers of two, the digits are extracted by shifts
+            const unsigned int shift = base == 16U ? 4U : base == 8U ? 3U : 1U;
+            do
+            {
+                const char digit = (char)(value & (base - 1U));
+                buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
+                value >>= shift;
+            } while (value && (len < PRINTF_NTOA_BUFFER_SIZE));
+        }
     }
 
     return _ntoa_format(out, buffer, idx, maxlen, buf, len, negative, (unsigned int)base, prec, width, flags);
@@ -352,12 +415,31 @@ static size_t _ntoa_long_long(out_fct_type       out,
     // write if precision != 0 and value is != 0
     if (!(flags & FLAGS_PRECISION) || value)
     {
-        do
+        if (base == 10U)
         {
-            const char digit = (char)(value % base);
-            buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
-            value /= base;
-        } while (value && (len < PRINTF_NTOA_BUFFER_SIZE));
+            // the value is converted in chunks of 9 digits fitting into unsigned long,
+            // so that only the split needs a 64-bit division on 32-bit targets
+#if ULONG_MAX < ULLONG_MAX
+            while (value > ULONG_MAX)
+            {
+                const unsigned long long high = value / 1000000000U;
+                len = _dec_rev(buf, len, (unsigned long)(value - high * 1000000000U), 9U);
+                value = high;
+            }
+#endif
+            len = _dec_rev(buf, len, (unsigned long)value, 0U);
+        }
+        else
+        {
+            // the other bases are powers of two, the digits are extracted by shifts
+            const unsigned int shift = base == 16U ? 4U : base == 8U ? 3U : 1U;
+            do
+            {
+                const char digit = (char)(value & (base - 1U));
+                buf[len++] = digit < 10 ? '0' + digit : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + digit - 10;
+                value >>= shift;
+            } while (value && (len < PRINTF_NTOA_BUFFER_SIZE));
+        }
     }
 
     return _ntoa_format(out, buffer, idx, maxlen, buf, len, negative, (unsigned int)base, prec, width, flags);
@@ -896,6 +978,19 @@ _vsnprintf(out_fct_type out, char *buffer, const size_t maxlen, const char *form
                                               precision,
                                               width,
                                               flags);
+#else
+                        // the argument is consumed, but only its value converted to long is printed
+                        const long value = (long)va_arg(va, long long);
+                        idx              = _ntoa_long(out,
+                                         buffer,
+                                         idx,
+                                         maxlen,
+                                         (unsigned long)(value > 0 ? value : 0 - value),
+                                         value < 0,
+                                         base,
+                                         precision,
+                                         width,
+                                         flags);
 #endif
                     }
                     else if (flags & FLAGS_LONG)
@@ -945,6 +1040,18 @@ _vsnprintf(out_fct_type out, char *buffer, const size_t maxlen, const char *form
                                               precision,
                                               width,
                                               flags);
+#else
+                        // the argument is consumed, but only its value converted to unsigned long is printed
+                        idx = _ntoa_long(out,
+                                         buffer,
+                                         idx,
+                                         maxlen,
+                                         (unsigned long)va_arg(va, unsigned long long),
+                                         false,
+                                         base,
+                                         precision,
+                                         width,
+                                         flags);
 #endif
                     }
                     else if (flags & FLAGS_LONG)
@@ -1162,9 +1269,7 @@ int fctprintf(void (*out)(char character, void *arg), void *arg, const char *for
     return ret;
 }
 
-extern _READ_WRITE_RETURN_TYPE write(int fd, const void *ptr, size_t len);
-
 void _putchar(char character)
 {
-    write(1, &character, 1);
+    bm_console_putc(character);
 }
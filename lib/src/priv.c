@@ -6,18 +6,20 @@
 #include "baremetal/common.h"
 #include "baremetal/csr.h"
 #include "baremetal/interrupt_low.h"
+#include "baremetal/per_hart.h"
 #include "baremetal/verbose.h"
 
-// Current privilege level
-volatile bm_priv_mode_t bm_current_mode = BM_PRIV_MODE_MACHINE;
+// Current privilege level of each hart
+BM_PER_HART volatile bm_priv_mode_t bm_current_mode = BM_PRIV_MODE_MACHINE;
 
 // Stack pointers saved for each privilege level,
 // stack pointer only needs to be saved once lower privilege mode is entered
-volatile xlen_t bm_priv_sp[4] = {0};
+// (referenced from the trap handler assembly only)
+USED BM_PER_HART volatile xlen_t bm_priv_sp[4] = {0};
 
 // Registers from execution in previous privilege mode saved upon trapping
 // to highed privilege mode on interrupt/exception
-volatile bm_register_file_t bm_priv_regs[4] = {{0}};
+USED BM_PER_HART volatile bm_register_file_t bm_priv_regs[4] = {{0}};
 
 bm_priv_mode_t bm_get_priv_mode(void)
 {
@@ -43,6 +43,11 @@ struct bm_spi_regs {
 #define SR_BIT_TX_EMPTY     (1 << 2)
 #define SR_BIT_TX_FULL      (1 << 3)
 
+#define DGIER_BIT_GIE       (1u << 31)
+
+#define IPI_BIT_TX_EMPTY      (1 << 2)
+#define IPI_BIT_TX_HALF_EMPTY (1 << 6)
+
 #define SSEL_DEASSERT_ALL   0xFFFFFFFF
 #define SSEL_ASSERT_0       0xFFFFFFFE
 
@@ -50,6 +55,11 @@ void bm_spi_init(bm_spi_t *spi)
 {
     bm_spi_cs_deassert(spi);
 
+    // Interrupts are only enabled during asynchronous transfers
+    spi->regs->DGIER = 0;
+    spi->regs->IPIER = 0;
+    spi->async.busy  = false;
+
     spi->regs->SPICR = CR_BIT_MANUAL_SSEL | CR_BIT_MASTER | CR_BIT_SPE | CR_BIT_TXFIFO_RESET |
                        CR_BIT_RXFIFO_RESET;
 }
@@ -64,24 +74,161 @@ void bm_spi_cs_deassert(bm_spi_t *spi)
     spi->regs->SPISSR = SSEL_DEASSERT_ALL;
 }
 
-void bm_spi_txrx_bufs(bm_spi_t *spi, const uint8_t *txbuf, uint8_t *rxbuf, size_t size)
+/**
+ * \brief Write bytes to the TX FIFO, keeping at most BM_SPI_FIFO_DEPTH bytes in flight
+ *
+ * \param spi SPI device
+ * \param txbuf Data to transmit, 0xff is transmitted if NULL
+ * \param tx_pos Number of bytes already written
+ * \param rx_pos Number of bytes already received
+ * \param size Number of bytes to transfer
+ *
+ * \return Number of bytes written including the previous ones
+ */
+static size_t fill_tx_fifo(bm_spi_t *spi, const uint8_t *txbuf, size_t tx_pos, size_t rx_pos, size_t size)
 {
-    for (unsigned i = 0; i < size; ++i)
+    // The RX FIFO has the same depth, so it cannot overflow
+    while (tx_pos < size && tx_pos - rx_pos < BM_SPI_FIFO_DEPTH)
     {
-        spi->regs->SPIDTR = txbuf ? txbuf[i] : 0xff;
+        spi->regs->SPIDTR = txbuf ? txbuf[tx_pos] : 0xff;
+        tx_pos++;
+    }
 
-        while (spi->regs->SPISR & SR_BIT_RX_EMPTY)
-            ;
+    return tx_pos;
+}
+
+/**
+ * \brief Read all bytes available in the RX FIFO
+ *
+ * \param spi SPI device
+ * \param rxbuf Buffer to store the received data in, the data are discarded if NULL
+ * \param rx_pos Number of bytes already received
+ *
+ * \return Number of bytes received including the previous ones
+ */
+static size_t drain_rx_fifo(bm_spi_t *spi, uint8_t *rxbuf, size_t rx_pos)
+{
+    if (spi->regs->SPISR & SR_BIT_RX_EMPTY)
+    {
+        return rx_pos;
+    }
+
+    // The occupancy register holds the number of bytes in the FIFO minus one
+    size_t count = spi->regs->RFOCC + 1;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint8_t data = spi->regs->SPIDRR;
 
         if (rxbuf)
         {
-            rxbuf[i] = spi->regs->SPIDRR;
+            rxbuf[rx_pos] = data;
         }
-        else
+        rx_pos++;
+    }
+
+    return rx_pos;
+}
+
+void bm_spi_txrx_bufs(bm_spi_t *spi, const uint8_t *txbuf, uint8_t *rxbuf, size_t size)
+{
+    size_t tx_pos = 0;
+    size_t rx_pos = 0;
+
+    while (rx_pos < size)
+    {
+        tx_pos = fill_tx_fifo(spi, txbuf, tx_pos, rx_pos, size);
+        rx_pos = drain_rx_fifo(spi, rxbuf, rx_pos);
+    }
+}
+
+int bm_spi_transfer_async(bm_spi_t         *spi,
+                          const uint8_t    *txbuf,
+                          uint8_t          *rxbuf,
+                          size_t            size,
+                          bm_spi_callback_t callback,
+                          void             *ctx)
+{
+    bm_spi_async_t *async = &spi->async;
+
+    if (async->busy)
+    {
+        return -1;
+    }
+
+    if (size == 0)
+    {
+        if (callback)
         {
-            (void)spi->regs->SPIDRR;
+            callback(ctx);
         }
+        return 0;
     }
+
+    async->txbuf    = txbuf;
+    async->rxbuf    = rxbuf;
+    async->size     = size;
+    async->rx_pos   = 0;
+    async->callback = callback;
+    async->ctx      = ctx;
+    async->busy     = true;
+
+    // Clear stale events, the status bits are toggled by writing ones
+    spi->regs->IPISR = spi->regs->IPISR;
+
+    async->tx_pos = fill_tx_fifo(spi, txbuf, 0, 0, size);
+
+    // Refill when the TX FIFO gets half empty, the last bytes are collected once it is empty
+    spi->regs->IPIER = IPI_BIT_TX_EMPTY | IPI_BIT_TX_HALF_EMPTY;
+    spi->regs->DGIER = DGIER_BIT_GIE;
+    bm_ext_irq_enable(spi->ext_irq_id);
+
+    return 0;
+}
+
+bool bm_spi_transfer_busy(bm_spi_t *spi)
+{
+    return spi->async.busy;
+}
+
+void bm_spi_transfer_wait(bm_spi_t *spi)
+{
+    while (spi->async.busy)
+        ;
+}
+
+int bm_spi_handle_irq(bm_spi_t *spi)
+{
+    bm_spi_async_t *async = &spi->async;
+
+    // Acknowledge the events before moving the data, so that no new event is lost
+    spi->regs->IPISR = spi->regs->IPISR;
+
+    if (!async->busy)
+    {
+        return -1;
+    }
+
+    async->rx_pos = drain_rx_fifo(spi, async->rxbuf, async->rx_pos);
+
+    if (async->rx_pos < async->size)
+    {
+        async->tx_pos = fill_tx_fifo(spi, async->txbuf, async->tx_pos, async->rx_pos, async->size);
+        return 0;
+    }
+
+    bm_ext_irq_disable(spi->ext_irq_id);
+    spi->regs->DGIER = 0;
+    spi->regs->IPIER = 0;
+
+    async->busy = false;
+
+    if (async->callback)
+    {
+        async->callback(async->ctx);
+    }
+
+    return 0;
 }
 
 void bm_spi_write_byte(bm_spi_t *spi, uint8_t data)
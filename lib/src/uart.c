@@ -5,6 +5,7 @@
 
 #include "baremetal/common.h"
 #include "baremetal/interrupt.h"
+#include "baremetal/ringbuf.h"
 
 #include <stdbool.h>
 #include <stddef.h>
@@ -62,98 +63,42 @@ struct bm_uart_regs {
 };
 
 /**
- * \brief Function for initialization of fifo structure
- *
- * \param f Pointer to the structure to initialize
- */
-static void fifo_init(bm_uart_fifo_t *f)
-{
-    f->start = 0;
-    f->pos   = 0;
-    f->size  = UART_FIFO_SIZE;
-}
-
-/**
- * \brief Function for checking whether fifo is empty
- *
- * \param f Pointer to the fifo structure
- *
- * \return True if the fifo is empty, false otherwise
- */
-static int fifo_empty(const bm_uart_fifo_t *f)
-{
-    return f->start == f->pos;
-}
-
-/**
- * \brief Function for checking whether fifo is full
- *
- * \param f Pointer to the structure of registers of the peripheral
- *
- * \return True if the fifo is full, false otherwise
- */
-static int fifo_full(const bm_uart_fifo_t *f)
-{
-    return f->start == ((f->pos + 1) % f->size);
-}
-
-/**
- * \brief Function for adding a single byte of data to the fifo
- *
- * \param f Pointer to the fifo structure
- * \param byte Data to add
+ * \brief Function to transmit internal buffer of UART driver structure,
+ * over the linked UART controller device
  *
- * \return 0 on success, -1 otherwise
+ * \param uart Pointer to the UART driver structure
  */
-static int fifo_push(bm_uart_fifo_t *f, uint8_t byte)
+static inline void fill_tx_fifo(bm_uart_t *uart)
 {
-    if (fifo_full(f))
+    // We have to wait until the THR and Tx FIFO are empty before filling
+    // as there is no FIFO Full bit
+    if (uart->regs->LSR & LSR_THRE)
     {
-        return -1;
-    }
+        uint8_t chunk[TX_FIFO_SIZE];
+        size_t  len = bm_ringbuf_pop(&uart->tx, chunk, TX_FIFO_SIZE);
 
-    f->buffer[f->pos] = byte;
-    f->pos            = (f->pos + 1) % f->size;
-
-    return 0;
-}
-
-/**
- * \brief Function for getting a single byte of data from the fifo
- *
- * \param f Pointer to the fifo structure
- *
- * \return Retrieved data on success, -1 otherwise
- */
-static int fifo_pop(bm_uart_fifo_t *f)
-{
-    if (fifo_empty(f))
-    {
-        return -1;
+        for (size_t i = 0; i < len; ++i)
+        {
+            uart->regs->THR = chunk[i];
+        }
     }
-
-    uint8_t byte = f->buffer[f->start];
-    f->start     = (f->start + 1) % f->size;
-
-    return byte;
 }
 
 /**
- * \brief Function to transmit internal buffer of UART driver structure,
- * over the linked UART controller device
+ * \brief Refill the Tx FIFO from a wait loop, with the UART interrupt masked
+ *
+ * Keeps the transmission going even if the interrupts are not enabled globally. The interrupt is
+ * masked only when the THR is empty, so the loop does not hammer the interrupt controller.
  *
  * \param uart Pointer to the UART driver structure
  */
-static inline void fill_tx_fifo(bm_uart_t *uart)
+static inline void kick_tx_fifo(bm_uart_t *uart)
 {
-    // We have to wait until the THR and Tx FIFO are empty before filling
-    // as there is no FIFO Full bit
     if (uart->regs->LSR & LSR_THRE)
     {
-        for (int i = 0; i < TX_FIFO_SIZE && !fifo_empty(&uart->tx); ++i)
-        {
-            uart->regs->THR = fifo_pop(&uart->tx);
-        }
+        bm_ext_irq_disable(uart->ext_irq_id);
+        fill_tx_fifo(uart);
+        bm_ext_irq_enable(uart->ext_irq_id);
     }
 }
 
@@ -165,23 +110,29 @@ static inline void fill_tx_fifo(bm_uart_t *uart)
  */
 static inline void clean_rx_fifo(bm_uart_t *uart)
 {
+    uint8_t chunk[TX_FIFO_SIZE];
+    size_t  len = 0;
+
+    // Drop new data in case of internal buffer overrun
     while (uart->regs->LSR & LSR_DR)
     {
-        uint8_t byte = uart->regs->RBR;
+        chunk[len++] = uart->regs->RBR;
 
-        // Drop new data in case of internal buffer overrun
-        if (!fifo_full(&uart->rx))
+        if (len == TX_FIFO_SIZE)
         {
-            fifo_push(&uart->rx, byte);
+            bm_ringbuf_push(&uart->rx, chunk, len);
+            len = 0;
         }
     }
+
+    bm_ringbuf_push(&uart->rx, chunk, len);
 }
 
 void bm_uart_init(bm_uart_t *uart, const bm_uart_config_t *config)
 {
     // Initialize internal buffers
-    fifo_init(&uart->rx);
-    fifo_init(&uart->tx);
+    bm_ringbuf_init(&uart->rx);
+    bm_ringbuf_init(&uart->tx);
 
     // Calculate the clock divisor
     unsigned divisor = (uart->freq + 8 * config->baud_rate) / (16 * config->baud_rate);
@@ -237,19 +188,38 @@ void bm_uart_transmit_byte(bm_uart_t *uart, uint8_t byte)
     }
     else
     {
-        // Block until some characters transmit
-        while (fifo_full(&uart->tx))
-            ;
+        bm_uart_write(uart, &byte, 1);
+    }
+}
 
-        // Disable all UART interrupts while pushing to the internal FIFO
-        bm_ext_irq_disable(uart->ext_irq_id);
-        fifo_push(&uart->tx, byte);
+void bm_uart_write(bm_uart_t *uart, const uint8_t *buf, size_t len)
+{
+    if (!uart->use_irq)
+    {
+        while (len > 0)
+        {
+            // Block until the THR and Tx FIFO are empty, then fill the whole Tx FIFO at once
+            while (!(uart->regs->LSR & LSR_THRE))
+                ;
+
+            for (int i = 0; i < TX_FIFO_SIZE && len > 0; ++i, --len)
+            {
+                uart->regs->THR = *buf++;
+            }
+        }
 
-        // Flush some or all of the internal FIFO if Transmit FIFO is Empty
-        fill_tx_fifo(uart);
+        return;
+    }
 
-        // Enable UART interrupts
-        bm_ext_irq_enable(uart->ext_irq_id);
+    while (len > 0)
+    {
+        // The FIFO is lock-free, only the transmitter needs to be guarded against the interrupt handler
+        size_t pushed = bm_ringbuf_push(&uart->tx, buf, len);
+        buf += pushed;
+        len -= pushed;
+
+        // Start the transmission if the Tx FIFO is empty, no THRE interrupt would come otherwise
+        kick_tx_fifo(uart);
     }
 }
 
@@ -267,19 +237,8 @@ int bm_uart_receive_byte(bm_uart_t *uart)
         return uart->regs->RBR;
     }
 
-    // No data available
-    if (fifo_empty(&uart->rx))
-    {
-        return -1;
-    }
-
-    int ret;
-    bm_ext_irq_disable(uart->ext_irq_id);
-    ret = fifo_pop(&uart->rx);
-    bm_ext_irq_enable(uart->ext_irq_id);
-
-    // Get the character
-    return ret;
+    // Get the character, or -1 if no data available
+    return bm_ringbuf_pop_byte(&uart->rx);
 }
 
 void bm_uart_flush(bm_uart_t *uart)
@@ -287,13 +246,15 @@ void bm_uart_flush(bm_uart_t *uart)
     if (uart->use_irq)
     {
         // Wait for characters to transmit and H/W FIFO to empty, under IRQ control
-        while (!fifo_empty(&uart->tx) || !(uart->regs->LSR & LSR_TEMT))
-            ;
+        while (!bm_ringbuf_empty(&uart->tx) || !(uart->regs->LSR & LSR_TEMT))
+        {
+            kick_tx_fifo(uart);
+        }
     }
     else
     {
         // Wait for characters to transmit and then re-fill H/W FIFO until S/W FIFO is empty
-        while (!fifo_empty(&uart->tx))
+        while (!bm_ringbuf_empty(&uart->tx))
         {
             fill_tx_fifo(uart);
         }
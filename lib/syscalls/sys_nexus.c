@@ -2,6 +2,7 @@
 /* SPDX-License-Identifier: BSD-3-Clause */
 
 #include "baremetal/common.h"
+#include "baremetal/console.h"
 #include "baremetal/verbose.h"
 
 #include <errno.h>
@@ -70,7 +71,18 @@ static int nexus_syscall(nexus_param_t *param, int ret)
     return param->ret;
 }
 
-_READ_WRITE_RETURN_TYPE USED _write(int file, const void *ptr, size_t len)
+const char bm_console_backend[] = "nexus";
+
+/**
+ * \brief Issue the write syscall through the debugger
+ *
+ * \param file File to write to
+ * \param ptr Pointer to buffer with characters to write
+ * \param len Number of characters to write
+ *
+ * \return Number of characters written on success, -1 on error
+ */
+static int nexus_write(int file, const void *ptr, size_t len)
 {
     nexus_param_t params = {.op        = CODASIP_SYSCALL_OP_WRITE,
                             .file_desc = file,
@@ -80,8 +92,30 @@ _READ_WRITE_RETURN_TYPE USED _write(int file, const void *ptr, size_t len)
     return nexus_syscall(&params, 0);
 }
 
+void bm_console_output(int fd, const void *ptr, size_t len)
+{
+    nexus_write(fd, ptr, len);
+}
+
+_READ_WRITE_RETURN_TYPE USED _write(int file, const void *ptr, size_t len)
+{
+    if (file == STDOUT_FILENO || file == STDERR_FILENO)
+    {
+        bm_console_write(file, ptr, len);
+        return len;
+    }
+
+    return nexus_write(file, ptr, len);
+}
+
 _READ_WRITE_RETURN_TYPE USED _read(int file, const void *ptr, size_t len)
 {
+    if (file == STDIN_FILENO)
+    {
+        // Make sure the prompt is visible before waiting for the input
+        bm_console_flush();
+    }
+
     nexus_param_t params = {.op        = CODASIP_SYSCALL_OP_READ,
                             .file_desc = file,
                             .len       = len,
@@ -128,6 +162,8 @@ void USED _exit(int ret)
         bm_info("Exited normally.");
     }
 
+    bm_console_exit();
+
     nexus_syscall(CODASIP_SYSCALL_EXIT_PARAM, ret);
 
     while (1)
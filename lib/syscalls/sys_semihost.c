@@ -2,6 +2,7 @@
 /* SPDX-License-Identifier: BSD-3-Clause */
 
 #include "baremetal/common.h"
+#include "baremetal/console.h"
 #include "baremetal/verbose.h"
 
 #include <errno.h>
@@ -46,7 +47,18 @@ int syscall_semihosting(xlen_t op, xlen_t param)
     return ret;
 }
 
-_READ_WRITE_RETURN_TYPE USED _write(int fd, const void *ptr, size_t len)
+const char bm_console_backend[] = "semihosting";
+
+/**
+ * \brief Issue the SYS_WRITE semihosting call
+ *
+ * \param handle Host handle of the file
+ * \param ptr Pointer to buffer with characters to write
+ * \param len Number of characters to write
+ *
+ * \return Number of characters not written
+ */
+static int semihosting_write(xlen_t handle, const void *ptr, size_t len)
 {
     struct params {
         xlen_t file_desc;
@@ -54,25 +66,34 @@ _READ_WRITE_RETURN_TYPE USED _write(int fd, const void *ptr, size_t len)
         xlen_t len;
     } my_params;
 
+    my_params.file_desc = handle;
+    my_params.len       = len;
+    my_params.ptr       = (xlen_t)ptr;
+    xlen_t addr         = (xlen_t)&my_params;
+
+    return syscall_semihosting(SEMIHOSTING_SYS_WRITE, addr);
+}
+
+void bm_console_output(int fd, const void *ptr, size_t len)
+{
+    semihosting_write(fd, ptr, len);
+}
+
+_READ_WRITE_RETURN_TYPE USED _write(int fd, const void *ptr, size_t len)
+{
     if (fd == STDOUT_FILENO || fd == STDERR_FILENO)
     {
-        my_params.file_desc = fd;
+        bm_console_write(fd, ptr, len);
+        return len;
     }
-    else if (open_fd & (1 << fd))
-    {
-        my_params.file_desc = fp[fd].handle;
-    }
-    else
+
+    if (!(open_fd & (1 << fd)))
     {
         errno = EBADF;
         return -1;
     }
 
-    my_params.len = len;
-    my_params.ptr = (xlen_t)ptr;
-    xlen_t addr   = (xlen_t)&my_params;
-
-    int ret = syscall_semihosting(SEMIHOSTING_SYS_WRITE, addr);
+    int ret = semihosting_write(fp[fd].handle, ptr, len);
 
     return (len - ret);
 }
@@ -87,6 +108,8 @@ _READ_WRITE_RETURN_TYPE USED _read(int fd, void *ptr, size_t len)
 
     if (fd == STDIN_FILENO)
     {
+        // Make sure the prompt is visible before waiting for the input
+        bm_console_flush();
         my_params.file_desc = fd;
     }
     else if (open_fd & (1 << fd))
@@ -257,6 +280,8 @@ void USED _exit(int ret)
         bm_info("Exited with an error.");
     }
 
+    bm_console_exit();
+
     xlen_t addr;
 #if __riscv_xlen == 32
     addr = (ret == 0) ? (xlen_t)ADP_Stopped_ApplicationExit : (xlen_t)ADP_Stopped_RunTimeErrorUnknown;
@@ -2,6 +2,8 @@
 /* SPDX-License-Identifier: BSD-3-Clause */
 
 #include "baremetal/common.h"
+#include "baremetal/console.h"
+#include "baremetal/interrupt.h"
 #include "baremetal/platform.h"
 #include "baremetal/uart.h"
 #include "baremetal/verbose.h"
@@ -15,9 +17,28 @@
 
 #define BM_SYS_UART_BAUD 115200
 
+// Transmit in the background using the THRE interrupt, enabled by CONFIG_SYS_UART_IRQ
+#ifdef BM_SYS_UART_IRQ
+    #define BM_SYS_UART_USE_IRQ true
+#else
+    #define BM_SYS_UART_USE_IRQ false
+#endif
+
 static volatile bool bm_sys_init_done = false;
 static bm_uart_t    *sys_uart;
 
+const char bm_console_backend[] = "UART";
+
+#ifdef BM_SYS_UART_IRQ
+/**
+ * \brief Interrupt handler of the console UART
+ */
+static void bm_sys_uart_irq_handler(void)
+{
+    bm_uart_handle_irq(sys_uart);
+}
+#endif
+
 /**
  * \brief Initialize the UART peripheral to be used for syscalls
  *
@@ -36,17 +57,46 @@ static inline void bm_sys_uart_init(void)
                             .data_format = BM_UART_DATA_BITS_8,
                             .parity      = BM_UART_PARITY_NONE,
                             .stop        = BM_UART_STOP_BITS_1,
-                            .use_irq     = false};
+                            .use_irq     = BM_SYS_UART_USE_IRQ};
+
+#ifdef BM_SYS_UART_IRQ
+    // The interrupts still need to be enabled globally by the application, e.g. by bm_interrupt_init()
+    bm_ext_irq_set_handler(sys_uart->ext_irq_id, bm_sys_uart_irq_handler);
+    bm_interrupt_enable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MEIP);
+#endif
+
     bm_uart_init(sys_uart, &cfg);
 
     bm_sys_init_done = true;
 }
 
+void bm_console_output(int fd UNUSED, const void *ptr, size_t len)
+{
+    bm_sys_uart_init();
+
+    const uint8_t *buf   = (const uint8_t *)ptr;
+    size_t         start = 0;
+
+    // Transmit the chars over UART in chunks, each line ending is preceded by '\r'
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (buf[i] == '\n')
+        {
+            bm_uart_write(sys_uart, buf + start, i - start);
+            bm_uart_write(sys_uart, (const uint8_t *)"\r", 1);
+            start = i;
+        }
+    }
+    bm_uart_write(sys_uart, buf + start, len - start);
+}
+
 /**
  * \brief Implementation of the write syscall using UART peripheral
  *
  * Assumes a UART peripheral is available on the target,
  * and that no code outside this file is using the peripheral.
+ * Stdout is buffered (see baremetal/console.h), and the function does not wait
+ * for the transmission to finish, the output is flushed on exit.
  *
  * \param fd File to write to
  * \param ptr Pointer to buffer with characters to write
@@ -62,18 +112,7 @@ _READ_WRITE_RETURN_TYPE USED _write(int fd, const void *ptr, size_t len)
         return -1;
     }
 
-    bm_sys_uart_init();
-
-    // Transmit the chars over UART
-    for (unsigned i = 0; i < len; ++i)
-    {
-        if (((char *)ptr)[i] == '\n')
-        {
-            bm_uart_transmit_byte(sys_uart, '\r');
-        }
-        bm_uart_transmit_byte(sys_uart, ((char *)ptr)[i]);
-    }
-    bm_uart_flush(sys_uart);
+    bm_console_write(fd, ptr, len);
 
     return len;
 }
@@ -100,6 +139,9 @@ _READ_WRITE_RETURN_TYPE USED _read(int fd, void *ptr, size_t len)
 
     bm_sys_uart_init();
 
+    // Make sure the prompt is visible before waiting for the input
+    bm_console_flush();
+
     size_t bytes_read = 0;
 
     // Receive the chars over UART
@@ -135,6 +177,13 @@ void USED _exit(int ret)
         bm_info("Exited normally.");
     }
 
+    bm_console_exit();
+
+    if (bm_sys_init_done)
+    {
+        bm_uart_flush(sys_uart);
+    }
+
     while (1)
         ;
 }
@@ -11,6 +11,7 @@ CONFIG_PLATFORM             = Hobgoblin
 CONFIG_CORE_FREQ            ?= 50
 CONFIG_NUM_HARTS            ?= 1
 CONFIG_HAS_PMP              = N
+CONFIG_PARALLEL_BSS         ?= N
 
 # ----[ PLATFORM CONFIGURATION ]----
 
@@ -12,6 +12,7 @@
 #define TARGET_HAS_HPM
 #define TARGET_HAS_CUSTOM_CSR
 #define TARGET_HAS_CACHE
+#define TARGET_CACHE_LINE_SIZE 64
 
 #ifdef CONFIG_HAS_PMP
     #define TARGET_HAS_PMP
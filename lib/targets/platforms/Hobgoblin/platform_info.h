@@ -3,6 +3,10 @@
 
 #define TARGET_PLATFORM_NAME "Hobgoblin"
 
+#ifndef TARGET_SIMULATION
+    #define TARGET_HAS_CLINT
+#endif
+
 #if !defined(TARGET_SIMULATION) && defined(CONFIG_PLIC)
     #define TARGET_HAS_PLIC
 #endif
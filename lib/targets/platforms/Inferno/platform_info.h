@@ -3,6 +3,10 @@
 
 #define TARGET_PLATFORM_NAME        "Inferno"
 
+#ifndef TARGET_SIMULATION
+    #define TARGET_HAS_CLINT
+#endif
+
 #define TARGET_TIMER_ADDR           CLINT_ADDR /* This is required for FreeRTOS support */
 
 #define TARGET_PLATFORM_FREQ        TARGET_CLK_FREQ
@@ -64,6 +64,10 @@ bin: $(BUILD_DIR)$(APP).bin
 %.bin: %.xexe
 	$(OBJCOPY) -O binary $^ $@
 
+.PHONY: size
+size: $(BUILD_DIR)$(APP).xexe $(BUILD_DIR)./lib/src/printf.o
+	$(SIZE) $^
+
 .PHONY: run
 run: $(BUILD_DIR)$(APP).xexe
 	$(if $(SIM),,$(error SIM variable must be set to run simulator))
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+# Copyright 2024 Codasip s.r.o.
+# SPDX-License-Identifier: BSD-3-Clause
+
+"""Decode the records of the bare-metal deferred log (see lib/include/baremetal/log.h).
+
+Reads the captured console output from a file or stdin, replaces the lines starting with
+#BMLOG by the formatted messages and passes the other lines through unchanged. The format
+strings are read from the ELF file of the application.
+
+Usage: bmlog.py application.xexe [console.log]
+"""
+
+import re
+import struct
+import sys
+
+LINE_PREFIX = "#BMLOG"
+MAX_ARGS = 7
+
+# Conversion specification of printf: flags, width, precision, length and conversion
+SPEC_RE = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|j|z|t|L)?([diouxXcspf%])")
+
+
+class Elf:
+    """Minimal ELF reader mapping addresses of the loaded segments to their contents."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+
+        if self.data[:4] != b"\x7fELF":
+            raise ValueError(f"{path} is not an ELF file")
+
+        self.is64 = self.data[4] == 2
+        self.endian = "<" if self.data[5] == 1 else ">"
+        self.xlen = 64 if self.is64 else 32
+
+        if self.is64:
+            phoff, phentsize, phnum = self._unpack("Q", 0x20)[0], *self._unpack("HH", 0x36)
+        else:
+            phoff, phentsize, phnum = self._unpack("I", 0x1C)[0], *self._unpack("HH", 0x2A)
+
+        # (virtual address, file offset, size in file) of each PT_LOAD segment
+        self.segments = []
+        for i in range(phnum):
+            off = phoff + i * phentsize
+            if self.is64:
+                p_type, _, p_offset, p_vaddr, _, p_filesz = self._unpack("IIQQQQ", off)
+            else:
+                p_type, p_offset, p_vaddr, _, p_filesz = self._unpack("IIIII", off)
+            if p_type == 1:
+                self.segments.append((p_vaddr, p_offset, p_filesz))
+
+    def _unpack(self, fmt, offset):
+        return struct.unpack_from(self.endian + fmt, self.data, offset)
+
+    def string(self, address):
+        """Return the null-terminated string at given address, or None if it is not in the file."""
+        for vaddr, offset, size in self.segments:
+            if vaddr <= address < vaddr + size:
+                start = offset + address - vaddr
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode("utf-8", errors="replace")
+        return None
+
+
+def to_signed(value, bits):
+    return value - (1 << bits) if value & (1 << (bits - 1)) else value
+
+
+def format_message(elf, fmt, args):
+    """Format the message the same way as printf on the target, with xlen-wide arguments."""
+    args = list(args)
+
+    def convert(match):
+        flags, width, precision, _, conv = match.groups()
+        if conv == "%":
+            return "%"
+
+        if width == "*":
+            width = str(to_signed(args.pop(0), elf.xlen)) if args else ""
+        if precision == "*":
+            precision = str(args.pop(0)) if args else ""
+        value = args.pop(0) if args else 0
+
+        spec = "%" + flags + (width or "") + ("." + precision if precision else "")
+        if conv in "di":
+            return (spec + "d") % to_signed(value, elf.xlen)
+        if conv in "ouxX":
+            return (spec + conv) % value
+        if conv == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if conv == "p":
+            return (spec + "s") % hex(value)
+        if conv == "s":
+            text = elf.string(value)
+            return (spec + "s") % (text if text is not None else f"<string at {value:#x}>")
+        return (spec + "s") % f"<{conv} not supported>"
+
+    return SPEC_RE.sub(convert, fmt)
+
+
+def decode_line(elf, line):
+    fields = line.split()
+    hart = int(fields[1], 16)
+    words = [int(word, 16) for word in fields[2:]]
+
+    header = words[0]
+    address = header & ~MAX_ARGS
+    args = words[1:]
+
+    if address == 0:
+        return f"[hart{hart}] {args[0]} log records dropped\n"
+
+    fmt = elf.string(address)
+    if fmt is None:
+        return f"[hart{hart}] unknown format string at {address:#x}, arguments {args}\n"
+
+    return f"[hart{hart}] " + format_message(elf, fmt, args)
+
+
+def main():
+    if len(sys.argv) not in (2, 3):
+        sys.exit(__doc__)
+
+    elf = Elf(sys.argv[1])
+    source = open(sys.argv[2], errors="replace") if len(sys.argv) == 3 else sys.stdin
+
+    for line in source:
+        # UART output contains '\r' before the line endings
+        stripped = line.rstrip("\r\n")
+        if stripped.startswith(LINE_PREFIX):
+            sys.stdout.write(decode_line(elf, stripped))
+        else:
+            sys.stdout.write(stripped + "\n")
+
+
+if __name__ == "__main__":
+    main()
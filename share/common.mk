@@ -61,17 +61,20 @@ CC = $(DETECTED_PREFIX)$(CC_NAME)$(OS_SUFFIX)
 
 ifneq ($(findstring codasip,$(COMPILER_VERSION_STRING)),)
 OBJCOPY ?= $(DETECTED_PREFIX)llvm-objcopy$(OS_SUFFIX)
+SIZE ?= $(DETECTED_PREFIX)llvm-size$(OS_SUFFIX)
 CC_TYPE = codasip_clang
 LD_TARGET = codasip
 SIM ?= $(DETECTED_PREFIX)isimulator$(OS_SUFFIX)
 
 else ifneq ($(findstring clang,$(COMPILER_VERSION_STRING)),)
 OBJCOPY ?= $(DETECTED_PREFIX)objcopy$(OS_SUFFIX)
+SIZE ?= $(DETECTED_PREFIX)size$(OS_SUFFIX)
 CC_TYPE = riscv_clang
 LD_TARGET = riscv
 
 else ifneq ($(findstring gcc,$(COMPILER_VERSION_STRING)),)
 OBJCOPY ?= $(DETECTED_PREFIX)objcopy$(OS_SUFFIX)
+SIZE ?= $(DETECTED_PREFIX)size$(OS_SUFFIX)
 CC_TYPE = riscv_gcc
 LD_TARGET = riscv
 
@@ -163,12 +166,15 @@ BM_CRT0 += $(LIB_DIR)/startup/crt0.S
 
 BM_SOURCES += \
     $(LIB_DIR)/src/barrier.c \
+    $(LIB_DIR)/src/console.c \
     $(LIB_DIR)/src/counter.c \
     $(LIB_DIR)/src/csr.c \
     $(LIB_DIR)/src/interrupt.c \
     $(LIB_DIR)/src/interrupt_low.c \
+    $(LIB_DIR)/src/log.c \
     $(LIB_DIR)/src/mp.c \
     $(LIB_DIR)/src/mutex.c \
+    $(LIB_DIR)/src/parallel.c \
     $(LIB_DIR)/src/priv.c \
     $(LIB_DIR)/src/printf.c
 
@@ -176,6 +182,39 @@ BM_SOURCES += \
 
 ifeq ($(CONFIG_ENVIRONMENT),SIMULATOR)
 DEFINES += TARGET_SIMULATION
+
+# Every console write traps to the simulator, so the output is only flushed when the buffer gets full
+CONFIG_CONSOLE_BUFFERING ?= FULL
+endif
+
+ifeq ($(CONFIG_CONSOLE_BUFFERING),NONE)
+DEFINES += BM_CONSOLE_DEFAULT_BUFFERING=BM_CONSOLE_UNBUFFERED
+else ifeq ($(CONFIG_CONSOLE_BUFFERING),FULL)
+DEFINES += BM_CONSOLE_DEFAULT_BUFFERING=BM_CONSOLE_FULLY_BUFFERED
+endif
+
+ifdef CONFIG_CONSOLE_BUFFER_SIZE
+DEFINES += BM_CONSOLE_BUFFER_SIZE=$(CONFIG_CONSOLE_BUFFER_SIZE)
+endif
+
+ifdef CONFIG_LOG_BUFFER_SIZE
+DEFINES += BM_LOG_BUFFER_SIZE=$(CONFIG_LOG_BUFFER_SIZE)
+endif
+
+# Features of the tiny printf: the default supports the integer conversions including long long,
+# FULL adds the floating point conversions, MINIMAL drops the long long support
+ifeq ($(CONFIG_PRINTF_PROFILE),FULL)
+DEFINES += PRINTF_SUPPORT_FLOAT PRINTF_SUPPORT_EXPONENTIAL PRINTF_SUPPORT_PTRDIFF_T
+else ifeq ($(CONFIG_PRINTF_PROFILE),MINIMAL)
+DEFINES += PRINTF_DISABLE_SUPPORT_LONG_LONG
+endif
+
+ifdef CONFIG_SPI_FIFO_DEPTH
+DEFINES += BM_SPI_FIFO_DEPTH=$(CONFIG_SPI_FIFO_DEPTH)
+endif
+
+ifeq ($(CONFIG_SYS_UART_IRQ),1)
+DEFINES += BM_SYS_UART_IRQ
 endif
 
 DEFINES += BUILD_VERSION=\"$(VERSION)\"
@@ -43,6 +43,19 @@
     #error Assembler did not define __riscv_xlen
 #endif
 
+#ifdef __riscv_flen
+    #if __riscv_flen == 64
+        #define store_f      fsd
+        #define load_f       fld
+    #else
+        #define store_f      fsw
+        #define load_f       flw
+    #endif
+    #define portFPU_REG_SIZE         ( __riscv_flen / 8 )
+#endif
+
+#include <baremetal/csr.h>
+
 #include "freertos_risc_v_chip_specific_extensions.h"
 
 /* Only the standard core registers are stored by default.  Any additional
@@ -54,6 +67,13 @@
     #define portCONTEXT_SIZE               ( 15 * portWORD_SIZE )
     #define portCRITICAL_NESTING_OFFSET    13
     #define portMSTATUS_OFFSET             14
+#elif defined( __riscv_flen )
+    /* The FPU registers and fcsr are stored above mstatus, the frame is
+     * rounded up to keep the stack 16 bytes aligned. */
+    #define portFPU_CONTEXT_OFFSET         ( 31 * portWORD_SIZE )
+    #define portCONTEXT_SIZE               ( ( portFPU_CONTEXT_OFFSET + 33 * portFPU_REG_SIZE + 15 ) & ~15 )
+    #define portCRITICAL_NESTING_OFFSET    29
+    #define portMSTATUS_OFFSET             30
 #else
     #define portCONTEXT_SIZE               ( 31 * portWORD_SIZE )
     #define portCRITICAL_NESTING_OFFSET    29
@@ -62,6 +82,84 @@
 
 /*-----------------------------------------------------------*/
 
+#ifdef __riscv_flen
+   .macro portcontextSAVE_FPU_CONTEXT
+store_f f0, portFPU_CONTEXT_OFFSET + 0 * portFPU_REG_SIZE( sp )
+store_f f1, portFPU_CONTEXT_OFFSET + 1 * portFPU_REG_SIZE( sp )
+store_f f2, portFPU_CONTEXT_OFFSET + 2 * portFPU_REG_SIZE( sp )
+store_f f3, portFPU_CONTEXT_OFFSET + 3 * portFPU_REG_SIZE( sp )
+store_f f4, portFPU_CONTEXT_OFFSET + 4 * portFPU_REG_SIZE( sp )
+store_f f5, portFPU_CONTEXT_OFFSET + 5 * portFPU_REG_SIZE( sp )
+store_f f6, portFPU_CONTEXT_OFFSET + 6 * portFPU_REG_SIZE( sp )
+store_f f7, portFPU_CONTEXT_OFFSET + 7 * portFPU_REG_SIZE( sp )
+store_f f8, portFPU_CONTEXT_OFFSET + 8 * portFPU_REG_SIZE( sp )
+store_f f9, portFPU_CONTEXT_OFFSET + 9 * portFPU_REG_SIZE( sp )
+store_f f10, portFPU_CONTEXT_OFFSET + 10 * portFPU_REG_SIZE( sp )
+store_f f11, portFPU_CONTEXT_OFFSET + 11 * portFPU_REG_SIZE( sp )
+store_f f12, portFPU_CONTEXT_OFFSET + 12 * portFPU_REG_SIZE( sp )
+store_f f13, portFPU_CONTEXT_OFFSET + 13 * portFPU_REG_SIZE( sp )
+store_f f14, portFPU_CONTEXT_OFFSET + 14 * portFPU_REG_SIZE( sp )
+store_f f15, portFPU_CONTEXT_OFFSET + 15 * portFPU_REG_SIZE( sp )
+store_f f16, portFPU_CONTEXT_OFFSET + 16 * portFPU_REG_SIZE( sp )
+store_f f17, portFPU_CONTEXT_OFFSET + 17 * portFPU_REG_SIZE( sp )
+store_f f18, portFPU_CONTEXT_OFFSET + 18 * portFPU_REG_SIZE( sp )
+store_f f19, portFPU_CONTEXT_OFFSET + 19 * portFPU_REG_SIZE( sp )
+store_f f20, portFPU_CONTEXT_OFFSET + 20 * portFPU_REG_SIZE( sp )
+store_f f21, portFPU_CONTEXT_OFFSET + 21 * portFPU_REG_SIZE( sp )
+store_f f22, portFPU_CONTEXT_OFFSET + 22 * portFPU_REG_SIZE( sp )
+store_f f23, portFPU_CONTEXT_OFFSET + 23 * portFPU_REG_SIZE( sp )
+store_f f24, portFPU_CONTEXT_OFFSET + 24 * portFPU_REG_SIZE( sp )
+store_f f25, portFPU_CONTEXT_OFFSET + 25 * portFPU_REG_SIZE( sp )
+store_f f26, portFPU_CONTEXT_OFFSET + 26 * portFPU_REG_SIZE( sp )
+store_f f27, portFPU_CONTEXT_OFFSET + 27 * portFPU_REG_SIZE( sp )
+store_f f28, portFPU_CONTEXT_OFFSET + 28 * portFPU_REG_SIZE( sp )
+store_f f29, portFPU_CONTEXT_OFFSET + 29 * portFPU_REG_SIZE( sp )
+store_f f30, portFPU_CONTEXT_OFFSET + 30 * portFPU_REG_SIZE( sp )
+store_f f31, portFPU_CONTEXT_OFFSET + 31 * portFPU_REG_SIZE( sp )
+frcsr t1
+sw t1, portFPU_CONTEXT_OFFSET + 32 * portFPU_REG_SIZE( sp )
+   .endm
+/*-----------------------------------------------------------*/
+
+   .macro portcontextRESTORE_FPU_CONTEXT
+load_f f0, portFPU_CONTEXT_OFFSET + 0 * portFPU_REG_SIZE( sp )
+load_f f1, portFPU_CONTEXT_OFFSET + 1 * portFPU_REG_SIZE( sp )
+load_f f2, portFPU_CONTEXT_OFFSET + 2 * portFPU_REG_SIZE( sp )
+load_f f3, portFPU_CONTEXT_OFFSET + 3 * portFPU_REG_SIZE( sp )
+load_f f4, portFPU_CONTEXT_OFFSET + 4 * portFPU_REG_SIZE( sp )
+load_f f5, portFPU_CONTEXT_OFFSET + 5 * portFPU_REG_SIZE( sp )
+load_f f6, portFPU_CONTEXT_OFFSET + 6 * portFPU_REG_SIZE( sp )
+load_f f7, portFPU_CONTEXT_OFFSET + 7 * portFPU_REG_SIZE( sp )
+load_f f8, portFPU_CONTEXT_OFFSET + 8 * portFPU_REG_SIZE( sp )
+load_f f9, portFPU_CONTEXT_OFFSET + 9 * portFPU_REG_SIZE( sp )
+load_f f10, portFPU_CONTEXT_OFFSET + 10 * portFPU_REG_SIZE( sp )
+load_f f11, portFPU_CONTEXT_OFFSET + 11 * portFPU_REG_SIZE( sp )
+load_f f12, portFPU_CONTEXT_OFFSET + 12 * portFPU_REG_SIZE( sp )
+load_f f13, portFPU_CONTEXT_OFFSET + 13 * portFPU_REG_SIZE( sp )
+load_f f14, portFPU_CONTEXT_OFFSET + 14 * portFPU_REG_SIZE( sp )
+load_f f15, portFPU_CONTEXT_OFFSET + 15 * portFPU_REG_SIZE( sp )
+load_f f16, portFPU_CONTEXT_OFFSET + 16 * portFPU_REG_SIZE( sp )
+load_f f17, portFPU_CONTEXT_OFFSET + 17 * portFPU_REG_SIZE( sp )
+load_f f18, portFPU_CONTEXT_OFFSET + 18 * portFPU_REG_SIZE( sp )
+load_f f19, portFPU_CONTEXT_OFFSET + 19 * portFPU_REG_SIZE( sp )
+load_f f20, portFPU_CONTEXT_OFFSET + 20 * portFPU_REG_SIZE( sp )
+load_f f21, portFPU_CONTEXT_OFFSET + 21 * portFPU_REG_SIZE( sp )
+load_f f22, portFPU_CONTEXT_OFFSET + 22 * portFPU_REG_SIZE( sp )
+load_f f23, portFPU_CONTEXT_OFFSET + 23 * portFPU_REG_SIZE( sp )
+load_f f24, portFPU_CONTEXT_OFFSET + 24 * portFPU_REG_SIZE( sp )
+load_f f25, portFPU_CONTEXT_OFFSET + 25 * portFPU_REG_SIZE( sp )
+load_f f26, portFPU_CONTEXT_OFFSET + 26 * portFPU_REG_SIZE( sp )
+load_f f27, portFPU_CONTEXT_OFFSET + 27 * portFPU_REG_SIZE( sp )
+load_f f28, portFPU_CONTEXT_OFFSET + 28 * portFPU_REG_SIZE( sp )
+load_f f29, portFPU_CONTEXT_OFFSET + 29 * portFPU_REG_SIZE( sp )
+load_f f30, portFPU_CONTEXT_OFFSET + 30 * portFPU_REG_SIZE( sp )
+load_f f31, portFPU_CONTEXT_OFFSET + 31 * portFPU_REG_SIZE( sp )
+lw t1, portFPU_CONTEXT_OFFSET + 32 * portFPU_REG_SIZE( sp )
+fscsr t1
+   .endm
+#endif /* ifdef __riscv_flen */
+/*-----------------------------------------------------------*/
+
 .extern pxCurrentTCB
    .extern xISRStackTop
    .extern xCriticalNesting
@@ -109,6 +207,17 @@ store_x t0, portCRITICAL_NESTING_OFFSET * portWORD_SIZE( sp ) /* Store the criti
 csrr t0, mstatus /* Required for MPIE bit. */
 store_x t0, portMSTATUS_OFFSET * portWORD_SIZE( sp )
 
+#ifdef __riscv_flen
+/* Save the FPU registers only if the task has written them, i.e. mstatus.FS
+ * is Dirty.  The FS field is not switched to Clean afterwards, as the frame is
+ * released when the task is resumed. */
+li  t1, BM_MSTATUS_FS_DIRTY
+and t2, t0, t1
+bne t2, t1, 1f
+portcontextSAVE_FPU_CONTEXT
+1:
+#endif
+
 
 portasmSAVE_ADDITIONAL_REGISTERS /* Defined in freertos_risc_v_chip_specific_extensions.h to save any registers unique to the RISC-V implementation. */
 
@@ -154,6 +263,17 @@ portasmRESTORE_ADDITIONAL_REGISTERS
 
 /* Load mstatus with the interrupt enable bits used by the task. */
 load_x t0, portMSTATUS_OFFSET * portWORD_SIZE( sp )
+
+#ifdef __riscv_flen
+/* Restore the FPU registers only if they were saved with the context. */
+li  t1, BM_MSTATUS_FS_DIRTY
+and t2, t0, t1
+bne t2, t1, 1f
+csrs mstatus, t1 /* Make the FPU accessible before loading the registers. */
+portcontextRESTORE_FPU_CONTEXT
+1:
+#endif
+
 csrw mstatus, t0                                             /* Required for MPIE bit. */
 
 load_x t0, portCRITICAL_NESTING_OFFSET * portWORD_SIZE( sp ) /* Obtain xCriticalNesting value for this task from task's stack. */
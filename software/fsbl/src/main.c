@@ -6,6 +6,7 @@
 #include "parser.h"
 
 #include <baremetal/common.h>
+#include <baremetal/console.h>
 #include <baremetal/csr.h>
 #include <baremetal/gpio.h>
 #include <baremetal/id_reg.h>
@@ -324,6 +325,9 @@ int main(void)
 #endif
     printf("\n");
 
+    // Nothing may stay buffered when the payloads take over the console
+    bm_console_flush();
+
 #if (TARGET_NUM_HARTS > 1)
     // check all harts are ready
     for (unsigned i = 1; i < TARGET_NUM_HARTS; ++i)
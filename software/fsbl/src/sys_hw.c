@@ -4,6 +4,7 @@
 #include "fatfs/ff.h"
 
 #include <baremetal/common.h>
+#include <baremetal/console.h>
 #include <baremetal/platform.h>
 #include <baremetal/uart.h>
 #include <baremetal/verbose.h>
@@ -149,23 +150,10 @@ _READ_WRITE_RETURN_TYPE USED _read(int fd, void *ptr, size_t len)
 
 #define BM_SYS_UART_BAUD 115200
 
-/**
- * \brief Implementation of the write syscall using UART peripheral
- *
- * \param fd File to write to
- * \param ptr Pointer to buffer with characters to write
- * \param len Number of characters to write
- *
- * \return Number of characters written on success, -1 on error
- */
-_READ_WRITE_RETURN_TYPE USED _write(int fd, const void *ptr, size_t len)
-{
-    if (fd != STDOUT_FILENO && fd != STDERR_FILENO)
-    {
-        errno = EBADF;
-        return -1;
-    }
+const char bm_console_backend[] = "UART";
 
+void bm_console_output(int fd UNUSED, const void *ptr, size_t len)
+{
     bm_uart_t *sys_uart = (bm_uart_t *)target_peripheral_get(BM_PERIPHERAL_UART_CONSOLE);
 
     static bool uart_init_done = false;
@@ -181,16 +169,45 @@ _READ_WRITE_RETURN_TYPE USED _write(int fd, const void *ptr, size_t len)
         uart_init_done = true;
     }
 
-    /* Transmit the chars over UART */
-    for (unsigned i = 0; i < len; ++i)
+    const uint8_t *buf   = (const uint8_t *)ptr;
+    size_t         start = 0;
+
+    /* Transmit the chars over UART, each line ending is preceded by '\r' */
+    for (size_t i = 0; i < len; ++i)
     {
-        if (((char *)ptr)[i] == '\n')
+        if (buf[i] == '\n')
         {
-            bm_uart_transmit_byte(sys_uart, '\r');
+            bm_uart_write(sys_uart, buf + start, i - start);
+            bm_uart_write(sys_uart, (const uint8_t *)"\r", 1);
+            start = i;
         }
-        bm_uart_transmit_byte(sys_uart, ((char *)ptr)[i]);
     }
+    bm_uart_write(sys_uart, buf + start, len - start);
+
+    /* The payload reinitializes the UART, so nothing can be left in the FIFO */
     bm_uart_flush(sys_uart);
+}
+
+/**
+ * \brief Implementation of the write syscall using UART peripheral
+ *
+ * Stdout is buffered (see baremetal/console.h), and flushed on newline.
+ *
+ * \param fd File to write to
+ * \param ptr Pointer to buffer with characters to write
+ * \param len Number of characters to write
+ *
+ * \return Number of characters written on success, -1 on error
+ */
+_READ_WRITE_RETURN_TYPE USED _write(int fd, const void *ptr, size_t len)
+{
+    if (fd != STDOUT_FILENO && fd != STDERR_FILENO)
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    bm_console_write(fd, ptr, len);
 
     return len;
 }
@@ -206,6 +223,8 @@ void USED _exit(int ret)
         bm_info("Exited normally.");
     }
 
+    bm_console_exit();
+
     while (1)
         ;
 }
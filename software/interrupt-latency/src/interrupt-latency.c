@@ -0,0 +1,308 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <baremetal/clint.h>
+#include <baremetal/common.h>
+#include <baremetal/csr.h>
+#include <baremetal/interrupt.h>
+#include <baremetal/interrupt_low.h>
+#include <baremetal/mem_barrier.h>
+#include <baremetal/mp.h>
+#include <baremetal/platform.h>
+#include <baremetal/time.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_SAMPLES      100000
+#define TIMER_DELAY      8    // Delay between arming the timer and the interrupt, in mtime ticks
+#define CALIBRATION_TIME 10   // Duration of the mtime to mcycle calibration, in milliseconds
+#define BUCKET_WIDTH     4    // Width of a histogram bucket, in cycles
+#define NUM_BUCKETS      1024 // Latencies above NUM_BUCKETS * BUCKET_WIDTH cycles fall into the last bucket
+#define BUFFER_WORDS     (64 * 1024 / sizeof(uint32_t))
+#define LINE_WORDS       (BM_CACHE_LINE_SIZE / sizeof(uint32_t))
+
+/** \brief Load running on the harts while waiting for the interrupts */
+typedef enum {
+    LOAD_IDLE,
+    LOAD_MEMORY,
+    LOAD_MULTI_HART,
+} load_t;
+
+static bm_clint_t *clint;
+static unsigned    hart_id;
+
+// mcycle cycles per mtime tick, in 24.8 fixed point format
+static uint64_t cycles_per_tick;
+
+// Expected cycle and time of the next interrupt, and the values sampled by the handler
+static uint64_t          deadline_cycles;
+static uint64_t          deadline_ticks;
+static volatile uint64_t entry_cycles;
+static volatile uint64_t entry_ticks;
+static volatile bool     fired;
+
+static uint32_t histogram[NUM_BUCKETS];
+static uint64_t latency_min;
+static uint64_t latency_max;
+static uint64_t ticks_max;
+
+static volatile uint32_t buffer[BUFFER_WORDS];
+static volatile bool     stop_load;
+
+/**
+ * \brief Sample the entry time and disarm the timer
+ */
+static inline void timer_handler_body(void)
+{
+    entry_cycles = bm_get_cycles();
+    entry_ticks  = bm_clint_get_mtime(clint);
+
+    bm_clint_set_mtimecmp(clint, hart_id, UINT64_MAX);
+    fired = true;
+}
+
+/**
+ * \brief Timer handler called by the library handlers
+ */
+void timer_handler(void)
+{
+    timer_handler_body();
+}
+
+#ifdef TARGET_HAS_CLIC
+/**
+ * \brief Timer handler called directly by the CLIC hardware vectoring
+ */
+void __attribute__((interrupt)) timer_handler_shv(void)
+{
+    timer_handler_body();
+}
+#endif
+
+/**
+ * \brief Measure how many cycles elapse during one mtime tick
+ */
+void calibrate(void)
+{
+    uint64_t ticks = bm_clint_ms_to_ticks(clint, CALIBRATION_TIME);
+
+    uint64_t start_ticks  = bm_clint_get_mtime(clint);
+    uint64_t start_cycles = bm_get_cycles();
+    while (bm_clint_get_mtime(clint) - start_ticks < ticks)
+    {
+    }
+    uint64_t cycles = bm_get_cycles() - start_cycles;
+
+    cycles_per_tick = (cycles << 8) / ticks;
+}
+
+/**
+ * \brief Stream over a part of the buffer until the load is stopped
+ */
+void memory_load(bm_hart_func_arg_t arg)
+{
+    size_t index = (size_t)arg;
+
+    while (!stop_load)
+    {
+        buffer[index] += 1;
+        index = (index + LINE_WORDS) % BUFFER_WORDS;
+    }
+}
+
+/**
+ * \brief Arm the timer so that it fires TIMER_DELAY ticks after an mtime tick edge
+ *
+ * Aligning to the edge makes the expected interrupt cycle independent of the phase of mtime.
+ */
+static void arm_timer(void)
+{
+    uint64_t prev = bm_clint_get_mtime(clint);
+    uint64_t now;
+
+    while ((now = bm_clint_get_mtime(clint)) == prev)
+    {
+    }
+
+    deadline_cycles = bm_get_cycles() + ((TIMER_DELAY * cycles_per_tick) >> 8);
+    deadline_ticks  = now + TIMER_DELAY;
+    fired           = false;
+
+    bm_clint_set_mtimecmp(clint, hart_id, deadline_ticks);
+}
+
+/**
+ * \brief Add the last interrupt to the histogram
+ */
+static void record_sample(void)
+{
+    uint64_t latency = entry_cycles > deadline_cycles ? entry_cycles - deadline_cycles : 0;
+    uint64_t ticks   = entry_ticks - deadline_ticks;
+    uint64_t bucket  = latency / BUCKET_WIDTH;
+
+    histogram[bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1]++;
+
+    latency_min = latency < latency_min ? latency : latency_min;
+    latency_max = latency > latency_max ? latency : latency_max;
+    ticks_max   = ticks > ticks_max ? ticks : ticks_max;
+}
+
+/**
+ * \brief Find the latency below which lies given fraction of the samples
+ *
+ * \param permille Fraction of the samples in permille
+ *
+ * \return Upper bound of the histogram bucket containing the percentile
+ */
+static uint64_t percentile(unsigned permille)
+{
+    uint64_t threshold = (uint64_t)NUM_SAMPLES * permille / 1000;
+    uint64_t count     = 0;
+
+    for (unsigned i = 0; i < NUM_BUCKETS - 1; ++i)
+    {
+        count += histogram[i];
+        if (count >= threshold)
+        {
+            return (i + 1) * BUCKET_WIDTH - 1;
+        }
+    }
+
+    return latency_max;
+}
+
+/**
+ * \brief Collect NUM_SAMPLES timer interrupts under given load and print the statistics
+ *
+ * \param name Name of the handler variant
+ * \param load Load running while waiting for the interrupts
+ */
+void measure(const char *name, load_t load)
+{
+    static const char *load_names[] = {"idle", "memory stress", "multi-hart"};
+
+    for (unsigned i = 0; i < NUM_BUCKETS; ++i)
+    {
+        histogram[i] = 0;
+    }
+    latency_min = UINT64_MAX;
+    latency_max = 0;
+    ticks_max   = 0;
+
+#if TARGET_NUM_HARTS > 1
+    if (load == LOAD_MULTI_HART)
+    {
+        stop_load = false;
+        bm_exec_fence();
+
+        for (unsigned i = 1; i < TARGET_NUM_HARTS; ++i)
+        {
+            bm_hart_start(i, memory_load, (bm_hart_func_arg_t)(i * BUFFER_WORDS / TARGET_NUM_HARTS));
+        }
+    }
+#endif
+
+    size_t index = 0;
+
+    for (unsigned i = 0; i < NUM_SAMPLES; ++i)
+    {
+        arm_timer();
+
+        if (load == LOAD_IDLE)
+        {
+            while (!fired)
+            {
+            }
+        }
+        else
+        {
+            while (!fired)
+            {
+                buffer[index] += 1;
+                index = (index + LINE_WORDS) % BUFFER_WORDS;
+            }
+        }
+
+        record_sample();
+    }
+
+#if TARGET_NUM_HARTS > 1
+    if (load == LOAD_MULTI_HART)
+    {
+        stop_load = true;
+        bm_exec_fence();
+
+        for (unsigned i = 1; i < TARGET_NUM_HARTS; ++i)
+        {
+            bm_hart_join(i);
+        }
+    }
+#endif
+
+    printf("%-22s %-14s min %5llu p50 %5llu p99 %5llu max %6llu cycles, jitter %6llu, max %llu ticks\n",
+           name,
+           load_names[load],
+           (unsigned long long)latency_min,
+           (unsigned long long)percentile(500),
+           (unsigned long long)percentile(990),
+           (unsigned long long)latency_max,
+           (unsigned long long)(latency_max - latency_min),
+           (unsigned long long)ticks_max);
+}
+
+/**
+ * \brief Measure the installed handler under all loads
+ */
+void measure_all(const char *name)
+{
+    measure(name, LOAD_IDLE);
+    measure(name, LOAD_MEMORY);
+
+    if (TARGET_NUM_HARTS > 1)
+    {
+        measure(name, LOAD_MULTI_HART);
+    }
+}
+
+int main(void)
+{
+    puts("Welcome to the interrupt latency benchmark!\n");
+
+    clint   = (bm_clint_t *)target_peripheral_get(BM_PERIPHERAL_CLINT);
+    hart_id = bm_get_hartid();
+
+    bm_clint_set_mtimecmp(clint, hart_id, UINT64_MAX);
+    calibrate();
+
+    printf("%u timer interrupts per measurement, %llu.%02llu cycles per mtime tick.\n",
+           NUM_SAMPLES,
+           (unsigned long long)(cycles_per_tick >> 8),
+           (unsigned long long)((cycles_per_tick & 0xff) * 100 >> 8));
+    printf("Latency is measured in cycles from the mtimecmp deadline to the handler entry.\n\n");
+
+    // Library handler saving the whole register file
+    bm_interrupt_init(BM_PRIV_MODE_MACHINE);
+    bm_interrupt_set_handler(BM_INTERRUPT_MTIP, timer_handler);
+    bm_interrupt_enable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MTIP);
+    measure_all("Managed handler");
+
+    // Library stubs saving only the caller-saved registers, the CLIC entry dispatches through mnxti
+    bm_interrupt_init_vectored(BM_PRIV_MODE_MACHINE);
+    measure_all("Fast vectored handler");
+
+#ifdef TARGET_HAS_CLIC
+    // Hardware vectoring, the core jumps directly to the handler found in the mtvt table
+    bm_interrupt_set_shv_handler(BM_INTERRUPT_MTIP, timer_handler_shv);
+    measure_all("CLIC SHV handler");
+    bm_interrupt_set_shv_handler(BM_INTERRUPT_MTIP, NULL);
+#endif
+
+    bm_interrupt_disable(BM_PRIV_MODE_MACHINE);
+    bm_interrupt_disable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MTIP);
+
+    puts("\nBye.");
+    return EXIT_SUCCESS;
+}
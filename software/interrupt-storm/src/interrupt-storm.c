@@ -0,0 +1,102 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <baremetal/clint.h>
+#include <baremetal/common.h>
+#include <baremetal/csr.h>
+#include <baremetal/interrupt.h>
+#include <baremetal/interrupt_low.h>
+#include <baremetal/mp.h>
+#include <baremetal/platform.h>
+#include <baremetal/time.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_INTERRUPTS 10000
+
+static bm_clint_t       *clint;
+static unsigned          hart_id;
+static volatile unsigned num_handled;
+
+/**
+ * \brief Count the interrupts, the software interrupt is left pending until the storm is over
+ */
+void ipi_handler(void)
+{
+    if (++num_handled == NUM_INTERRUPTS)
+    {
+        bm_clint_clear_ipi(clint, hart_id);
+    }
+}
+
+/**
+ * \brief Run one storm of software interrupts and print the cost per interrupt
+ *
+ * \param name Name of the measured variant
+ * \param fs_state State of the floating point unit set before the storm
+ */
+void storm(const char *name, xlen_t fs_state UNUSED)
+{
+    num_handled = 0;
+
+#ifdef __riscv_flen
+    bm_csr_clear_mask(BM_CSR_MSTATUS, BM_MSTATUS_FS_MASK);
+    bm_csr_set_mask(BM_CSR_MSTATUS, fs_state);
+#endif
+
+    uint64_t start = bm_get_cycles();
+
+    bm_clint_send_ipi(clint, hart_id);
+    while (num_handled < NUM_INTERRUPTS)
+    {
+    }
+
+    uint64_t cycles = bm_get_cycles() - start;
+
+    printf("%-36s %10llu cycles, %6llu per interrupt\n",
+           name,
+           (unsigned long long)cycles,
+           (unsigned long long)(cycles / NUM_INTERRUPTS));
+}
+
+/**
+ * \brief Run the storm with the currently installed handler in all floating point states
+ */
+void storm_variant(const char *name)
+{
+#ifdef __riscv_flen
+    char label[64];
+
+    snprintf(label, sizeof(label), "%s, FP unused", name);
+    storm(label, BM_MSTATUS_FS_INITIAL);
+    snprintf(label, sizeof(label), "%s, FP dirty", name);
+    storm(label, BM_MSTATUS_FS_DIRTY);
+#else
+    storm(name, 0);
+#endif
+}
+
+int main(void)
+{
+    puts("Welcome to the interrupt storm benchmark!\n");
+    printf("Handling %u back-to-back software interrupts.\n\n", NUM_INTERRUPTS);
+
+    clint   = (bm_clint_t *)target_peripheral_get(BM_PERIPHERAL_CLINT);
+    hart_id = bm_get_hartid();
+
+    bm_interrupt_enable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MSIP);
+
+    bm_interrupt_init(BM_PRIV_MODE_MACHINE);
+    bm_interrupt_set_handler(BM_INTERRUPT_MSIP, ipi_handler);
+    storm_variant("Default handler");
+
+    bm_interrupt_init_vectored(BM_PRIV_MODE_MACHINE);
+    storm_variant("Fast vectored handler");
+
+    bm_interrupt_disable(BM_PRIV_MODE_MACHINE);
+    bm_interrupt_disable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MSIP);
+
+    puts("\nBye.");
+    return EXIT_SUCCESS;
+}
@@ -4,17 +4,25 @@
 #include <baremetal/clint.h>
 #include <baremetal/common.h>
 #include <baremetal/csr.h>
+#include <baremetal/interrupt.h>
 #include <baremetal/interrupt_low.h>
 #include <baremetal/mp.h>
 #include <baremetal/platform.h>
 #include <baremetal/time.h>
 #include <baremetal/verbose.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#define NUM_ITERATIONS 1000
+
 static bm_clint_t *clint;
 static unsigned    clint_tics_in_second;
 
+// Cycle counter sampled at the start and at the end of the software interrupt handler
+static volatile uint64_t entry_cycles;
+static volatile uint64_t exit_cycles;
+
 /**
  * \brief A custom handler for unexpected interrupts
  */
@@ -45,6 +53,32 @@ void __attribute__((interrupt, aligned(16))) interrupt_handler(void)
     bm_clint_rearm_timer(clint, bm_get_hartid(), clint_tics_in_second);
 }
 
+/**
+ * \brief Body of the software interrupt handlers used for the latency measurement
+ */
+static inline void ipi_handler_body(void)
+{
+    entry_cycles = bm_get_cycles();
+    bm_clint_clear_ipi(clint, bm_get_hartid());
+    exit_cycles = bm_get_cycles();
+}
+
+/**
+ * \brief A custom interrupt handler for software interrupts
+ */
+void __attribute__((interrupt, aligned(16))) ipi_handler(void)
+{
+    ipi_handler_body();
+}
+
+/**
+ * \brief A plain function handling software interrupts, called by the library handlers
+ */
+void ipi_handler_managed(void)
+{
+    ipi_handler_body();
+}
+
 void __attribute__((naked, section(".text.mtvec_table"), aligned(16))) bm_irq_mtvec_table(void)
 {
     __asm__ volatile(".option push;"
@@ -52,7 +86,7 @@ void __attribute__((naked, section(".text.mtvec_table"), aligned(16))) bm_irq_mt
                      "j exception_handler;" // Exception
                      "j default_handler;"
                      "j default_handler;"
-                     "j default_handler;"
+                     "j ipi_handler;" // MSIP
                      "j default_handler;"
                      "j default_handler;"
                      "j default_handler;"
@@ -68,6 +102,66 @@ void __attribute__((naked, section(".text.mtvec_table"), aligned(16))) bm_irq_mt
                      ".option pop;");
 }
 
+/**
+ * \brief Measure entry and exit latency of a software interrupt with the currently installed handler
+ *
+ * \param name Name of the handler variant
+ * \param fs_state State of the floating point unit set before each interrupt
+ */
+void measure_latency(const char *name, xlen_t fs_state UNUSED)
+{
+    unsigned hart_id   = bm_get_hartid();
+    uint64_t entry_min = UINT64_MAX;
+    uint64_t entry_sum = 0;
+    uint64_t exit_min  = UINT64_MAX;
+    uint64_t exit_sum  = 0;
+
+    for (unsigned i = 0; i < NUM_ITERATIONS; ++i)
+    {
+#ifdef __riscv_flen
+        bm_csr_clear_mask(BM_CSR_MSTATUS, BM_MSTATUS_FS_MASK);
+        bm_csr_set_mask(BM_CSR_MSTATUS, fs_state);
+#endif
+        entry_cycles = 0;
+
+        uint64_t start = bm_get_cycles();
+        bm_clint_send_ipi(clint, hart_id);
+        while (entry_cycles == 0)
+        {
+        }
+        uint64_t end = bm_get_cycles();
+
+        uint64_t entry = entry_cycles - start;
+        uint64_t exit  = end - exit_cycles;
+
+        entry_min = entry < entry_min ? entry : entry_min;
+        exit_min  = exit < exit_min ? exit : exit_min;
+        entry_sum += entry;
+        exit_sum += exit;
+    }
+
+    printf("%-24s entry min %5llu avg %5llu, exit min %5llu avg %5llu cycles\n",
+           name,
+           (unsigned long long)entry_min,
+           (unsigned long long)(entry_sum / NUM_ITERATIONS),
+           (unsigned long long)exit_min,
+           (unsigned long long)(exit_sum / NUM_ITERATIONS));
+}
+
+/**
+ * \brief Measure the current handler with clean and dirty floating point state
+ */
+void measure_variant(const char *name)
+{
+#ifdef __riscv_flen
+    printf("%s:\n", name);
+    measure_latency("  FP state clean", BM_MSTATUS_FS_CLEAN);
+    measure_latency("  FP state dirty", BM_MSTATUS_FS_DIRTY);
+#else
+    measure_latency(name, 0);
+#endif
+}
+
 int main(void)
 {
     puts("Welcome to the interrupts-vectored demo!\n");
@@ -92,6 +186,27 @@ int main(void)
 
     // Stop the generation of interrupts
     bm_interrupt_disable(BM_PRIV_MODE_MACHINE);
+    bm_interrupt_disable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MTIP);
+
+    puts("\nMeasuring software interrupt latency...\n");
+    bm_interrupt_enable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MSIP);
+
+    // Custom vector table with handlers using the interrupt attribute
+    bm_interrupt_tvec_setup(BM_PRIV_MODE_MACHINE, (xlen_t)&bm_irq_mtvec_table, BM_INTERRUPT_MODE_VECTOR);
+    bm_interrupt_enable(BM_PRIV_MODE_MACHINE);
+    measure_variant("Attribute handler");
+
+    // Library handler saving the whole register file
+    bm_interrupt_init(BM_PRIV_MODE_MACHINE);
+    bm_interrupt_set_handler(BM_INTERRUPT_MSIP, ipi_handler_managed);
+    measure_variant("Managed handler");
+
+    // Library per-cause stubs saving only the caller-saved registers
+    bm_interrupt_init_vectored(BM_PRIV_MODE_MACHINE);
+    measure_variant("Fast vectored handler");
+
+    bm_interrupt_disable(BM_PRIV_MODE_MACHINE);
+    bm_interrupt_disable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MSIP);
 
     puts("Bye.");
     return EXIT_SUCCESS;
@@ -0,0 +1,144 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <baremetal/common.h>
+#include <baremetal/parallel.h>
+#include <baremetal/time.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MATRIX_SIZE 64
+
+static int32_t a[MATRIX_SIZE][MATRIX_SIZE];
+static int32_t b[MATRIX_SIZE][MATRIX_SIZE];
+static int32_t c[MATRIX_SIZE][MATRIX_SIZE];
+
+// Results of the last serial run, used as a reference for the parallel runs
+static uint64_t serial_cycles;
+static uint64_t serial_checksum;
+
+/**
+ * \brief Multiply rows [begin, end) of the matrices, ctx selects the triangular variant
+ */
+void multiply_rows(size_t begin, size_t end, void *ctx)
+{
+    bool triangular = *(const bool *)ctx;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        size_t columns = triangular ? i + 1 : MATRIX_SIZE;
+
+        for (size_t j = 0; j < columns; ++j)
+        {
+            int32_t sum = 0;
+            for (size_t k = 0; k < MATRIX_SIZE; ++k)
+            {
+                sum += a[i][k] * b[k][j];
+            }
+            c[i][j] = sum;
+        }
+    }
+}
+
+/**
+ * \brief Accumulate checksum of rows [begin, end) of the result
+ *
+ * Row hashes are combined by XOR, so the result does not depend on the chunking.
+ */
+uint64_t checksum_rows(size_t begin, size_t end, uint64_t acc, void *ctx UNUSED)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        uint64_t hash = i;
+        for (size_t j = 0; j < MATRIX_SIZE; ++j)
+        {
+            hash = hash * 0x9e3779b97f4a7c15ull + (uint32_t)c[i][j];
+        }
+        acc ^= hash;
+    }
+
+    return acc;
+}
+
+uint64_t combine_checksums(uint64_t x, uint64_t y)
+{
+    return x ^ y;
+}
+
+/**
+ * \brief Run one variant of the multiplication and print the results
+ *
+ * \param name Name of the variant
+ * \param parallel Use the parallel loop if true, run serially otherwise
+ * \param schedule Scheduling policy of the parallel loop
+ * \param triangular Compute only the lower-triangular part of the product
+ */
+void run(const char *name, bool parallel, bm_parallel_schedule_t schedule, bool triangular)
+{
+    for (size_t i = 0; i < MATRIX_SIZE; ++i)
+    {
+        for (size_t j = 0; j < MATRIX_SIZE; ++j)
+        {
+            c[i][j] = 0;
+        }
+    }
+
+    bm_parallel_set_schedule(schedule);
+
+    uint64_t start = bm_get_cycles();
+    if (parallel)
+    {
+        bm_parallel_for(0, MATRIX_SIZE, 0, multiply_rows, &triangular);
+    }
+    else
+    {
+        multiply_rows(0, MATRIX_SIZE, &triangular);
+    }
+    uint64_t cycles = bm_get_cycles() - start;
+
+    uint64_t sum = bm_parallel_reduce(0, MATRIX_SIZE, 0, checksum_rows, combine_checksums, 0, NULL);
+
+    if (!parallel)
+    {
+        serial_cycles   = cycles;
+        serial_checksum = checksum_rows(0, MATRIX_SIZE, 0, NULL);
+    }
+
+    printf("%-20s %10llu cycles, speedup %2u.%02u, checksum 0x%016llx %s\n",
+           name,
+           (unsigned long long)cycles,
+           (unsigned)(serial_cycles / cycles),
+           (unsigned)(serial_cycles * 100 / cycles % 100),
+           (unsigned long long)sum,
+           sum == serial_checksum ? "OK" : "MISMATCH");
+}
+
+int main(void)
+{
+    printf("Welcome to the matrix multiplication benchmark!\n\n");
+    printf("Multiplying %ux%u matrices on %u harts.\n\n", MATRIX_SIZE, MATRIX_SIZE, TARGET_NUM_HARTS);
+
+    srand(0);
+    for (size_t i = 0; i < MATRIX_SIZE; ++i)
+    {
+        for (size_t j = 0; j < MATRIX_SIZE; ++j)
+        {
+            a[i][j] = rand() % 256;
+            b[i][j] = rand() % 256;
+        }
+    }
+
+    run("Full, serial", false, BM_PARALLEL_SCHEDULE_STATIC, false);
+    run("Full, static", true, BM_PARALLEL_SCHEDULE_STATIC, false);
+    run("Full, dynamic", true, BM_PARALLEL_SCHEDULE_DYNAMIC, false);
+
+    run("Triangular, serial", false, BM_PARALLEL_SCHEDULE_STATIC, true);
+    run("Triangular, static", true, BM_PARALLEL_SCHEDULE_STATIC, true);
+    run("Triangular, dynamic", true, BM_PARALLEL_SCHEDULE_DYNAMIC, true);
+
+    puts("\nBye.");
+    return EXIT_SUCCESS;
+}
@@ -4,7 +4,11 @@
 #include <baremetal/common.h>
 #include <baremetal/csr.h>
 #include <baremetal/interrupt.h>
+#include <baremetal/mp.h>
+#include <baremetal/mutex.h>
+#include <baremetal/parallel.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -22,6 +26,7 @@
 #define DEBUG           0
 #define ERROR_THRESHOLD 128
 #define FAST_THRESHOLD  0x100000
+#define XLEN_BYTES      (__riscv_xlen / 8)
 
 extern int _start;
 extern int _end;
@@ -45,17 +50,48 @@ xlen_t     program_data_end   = (xlen_t)(uintptr_t)(&_end);
                      :: "r"(val), "r"(addr));
 // clang-format on
 
-static unsigned error_count = 0;
-static bool     error_flag  = false;
+/** \brief Per-hart error state, padded to a cache line to avoid false sharing */
+typedef struct {
+    volatile bool     flag;
+    volatile unsigned count;
+} __attribute__((aligned(BM_CACHE_LINE_SIZE))) hart_errors_t;
+
+/** \brief Parameters of a pass over the tested range */
+typedef struct {
+    xlen_t start;
+    unsigned (*size_gen)(size_t index);
+} pass_t;
+
+static hart_errors_t hart_errors[TARGET_NUM_HARTS];
+static volatile bool stop_test = false;
+static bm_mutex_t    print_mutex;
+
+unsigned total_errors(void)
+{
+    unsigned total = 0;
+
+    for (unsigned i = 0; i < TARGET_NUM_HARTS; ++i)
+    {
+        total += hart_errors[i].count;
+    }
+
+    return total;
+}
 
 void log_error(void)
 {
-    error_count++;
-    error_flag = true;
-    if (error_count > ERROR_THRESHOLD)
+    hart_errors[bm_get_hartid()].count++;
+    hart_errors[bm_get_hartid()].flag = true;
+
+    if (total_errors() > ERROR_THRESHOLD)
     {
-        puts("Too many errors, stopping.");
-        exit(1);
+        bm_mutex_lock(&print_mutex);
+        if (!stop_test)
+        {
+            puts("Too many errors, stopping.");
+            stop_test = true;
+        }
+        bm_mutex_unlock(&print_mutex);
     }
 }
 
@@ -64,7 +100,9 @@ void mem_error_handler(void)
     xlen_t mcause = bm_csr_read(BM_CSR_MCAUSE);
     xlen_t mtval  = bm_csr_read(BM_CSR_MTVAL);
 
+    bm_mutex_lock(&print_mutex);
     printf("Failed to %s at " BM_FMT_XLEN "\n", mcause == BM_EXCEPTION_LAF ? "read" : "write", mtval);
+    bm_mutex_unlock(&print_mutex);
 
     log_error();
 
@@ -126,18 +164,24 @@ xlen_t do_read(xlen_t address, unsigned size)
 
 void read_test(xlen_t offset, unsigned size, xlen_t test_value)
 {
-    error_flag = false;
+    hart_errors_t *errors = &hart_errors[bm_get_hartid()];
+
+    errors->flag = false;
 
     xlen_t mask     = ((xlen_t)-1) >> (__riscv_xlen - size);
     xlen_t read_val = do_read(offset, size) & mask;
     xlen_t cur_val  = test_value & mask;
 #if DEBUG
+    bm_mutex_lock(&print_mutex);
     printf("DEBUG: %3u-bit read at " BM_FMT_XLEN ":  " BM_FMT_XLEN "\n", size, offset, read_val);
+    bm_mutex_unlock(&print_mutex);
 #endif
-    if (!error_flag && read_val != cur_val)
+    if (!errors->flag && read_val != cur_val)
     {
+        bm_mutex_lock(&print_mutex);
         printf("Incorrect value read at " BM_FMT_XLEN "!\n", offset);
         printf("Expected " BM_FMT_XLEN ", read " BM_FMT_XLEN ".\n", cur_val, read_val);
+        bm_mutex_unlock(&print_mutex);
         log_error();
     }
 }
@@ -146,12 +190,33 @@ void write_test(xlen_t offset, unsigned size, xlen_t test_value)
 {
 #if DEBUG
     xlen_t mask = ((xlen_t)-1) >> (__riscv_xlen - size);
+    bm_mutex_lock(&print_mutex);
     printf("DEBUG: %3u-bit write at " BM_FMT_XLEN ": " BM_FMT_XLEN "\n", size, offset, test_value & mask);
+    bm_mutex_unlock(&print_mutex);
 #endif
     do_write(offset, size, test_value);
 }
 
-unsigned constant_size(void)
+/**
+ * \brief Generate pseudorandom test value from an address
+ *
+ * The value depends only on the address, so any hart can regenerate it independently.
+ */
+xlen_t test_value(xlen_t address)
+{
+    uint64_t x = (uint64_t)address * 0x9e3779b97f4a7c15ull;
+
+    x ^= x >> 29;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 32;
+
+    return (xlen_t)x;
+}
+
+// Number of available access widths, 8 .. XLEN
+#define NUM_SIZES ((__riscv_xlen == 64) ? 4 : 3)
+
+unsigned constant_size(size_t index UNUSED)
 {
     return 32;
 }
@@ -160,13 +225,9 @@ unsigned constant_size(void)
  * Iterate over all available access widths
  * 8 -> 16 -> .. -> XLEN
  */
-unsigned iterative_size(void)
+unsigned iterative_size(size_t index)
 {
-    static unsigned size = __riscv_xlen;
-
-    size = (size == __riscv_xlen) ? 8 : size * 2;
-
-    return size;
+    return 8u << (index % NUM_SIZES);
 }
 
 /**
@@ -177,54 +238,98 @@ unsigned iterative_size(void)
  * while iterative_size generates:
  * 8 -> 16 -> 32 -> 8 -> 16 -> 32 -> 8 -> 16 -> 32
  */
-unsigned iterative_size_squared(void)
+unsigned iterative_size_squared(size_t index)
 {
-    static unsigned size        = __riscv_xlen;
-    const unsigned  repetitions = (__riscv_xlen == 64) ? 4 : 3;
-    static unsigned repeat      = repetitions;
+    return 8u << ((index / NUM_SIZES) % NUM_SIZES);
+}
 
-    repeat = (repeat == 1) ? repetitions : repeat - 1;
-    if (repeat != repetitions)
+/**
+ * \brief Access all XLEN-wide words in the [begin, end) index range of a pass using given function.
+ *
+ * \param begin Index of the first word
+ * \param end Index after the last word
+ * \param pass Parameters of the pass
+ * \param mem_access Memory access function to test
+ */
+void access_words(size_t begin,
+                  size_t end,
+                  const pass_t *pass,
+                  void (*mem_access)(xlen_t offset, unsigned size, xlen_t cur_val))
+{
+    for (size_t i = begin; i < end && !stop_test; ++i)
     {
-        return size;
+        xlen_t   address = pass->start + (xlen_t)i * XLEN_BYTES;
+        unsigned size    = pass->size_gen(i);
+        xlen_t   value   = test_value(address);
+
+        for (xlen_t offset = address; offset < address + XLEN_BYTES; offset += size / 8)
+        {
+            mem_access(offset, size, value);
+
+            value >>= size;
+        }
     }
+}
+
+void write_words(size_t begin, size_t end, void *ctx)
+{
+    access_words(begin, end, (const pass_t *)ctx, write_test);
+}
 
-    size = (size == __riscv_xlen) ? 8 : size * 2;
+uint64_t read_words(size_t begin, size_t end, uint64_t acc, void *ctx)
+{
+    unsigned errors = hart_errors[bm_get_hartid()].count;
 
-    return size;
+    access_words(begin, end, (const pass_t *)ctx, read_test);
+
+    return acc + (hart_errors[bm_get_hartid()].count - errors);
+}
+
+uint64_t add(uint64_t a, uint64_t b)
+{
+    return a + b;
 }
 
 /**
- * \brief Iterate over given memory range, generating pseudorandom values and accessing memory using given functions.
+ * \brief Iterate over given memory range on all harts, accessing memory using given pass type.
  *
  * \param start Start of the memory to test
  * \param end End of the memory to test
- * \param mem_access Memory access function to test
  * \param size_gen Function to generate memory access widths
+ * \param read Read and check the values if true, write them otherwise
+ *
+ * \return Number of errors found when reading
  */
-void iterate_range(xlen_t start,
-                   xlen_t end,
-                   void (*mem_access)(xlen_t offset, unsigned size, xlen_t cur_val),
-                   unsigned (*size_gen)(void))
+unsigned iterate_range(xlen_t start, xlen_t end, unsigned (*size_gen)(size_t index), bool read)
 {
-    srand(0);
+    pass_t pass  = {.start = start, .size_gen = size_gen};
+    size_t words = (end - start) / XLEN_BYTES;
 
-    for (xlen_t address = start; address < end; address += __riscv_xlen / 8)
+    if (read)
     {
-        unsigned size       = size_gen();
-        xlen_t   test_value = rand();
-#if __riscv_xlen == 64
-        test_value <<= 32;
-        test_value |= rand();
-#endif
+        return (unsigned)bm_parallel_reduce(0, words, 0, read_words, add, 0, &pass);
+    }
 
-        for (xlen_t offset = address; offset < address + __riscv_xlen / 8; offset += size / 8)
-        {
-            mem_access(offset, size, test_value);
+    bm_parallel_for(0, words, 0, write_words, &pass);
+    return 0;
+}
 
-            test_value >>= size;
-        }
-    }
+#ifdef TARGET_HAS_CACHE
+/**
+ * \brief Flush and invalidate caches of the hart
+ */
+void invalidate_caches(bm_hart_func_arg_t arg UNUSED)
+{
+    bm_dcache_invalidate_all();
+}
+#endif
+
+/**
+ * \brief Install exception handling on the hart
+ */
+void init_exceptions(bm_hart_func_arg_t arg UNUSED)
+{
+    bm_interrupt_init(BM_PRIV_MODE_MACHINE);
 }
 
 /**
@@ -233,44 +338,50 @@ void iterate_range(xlen_t start,
  * \param start Start of the memory to test
  * \param end End of the memory to test
  * \param fast Toggle a fast mode testing
+ *
+ * \return Number of errors found when reading
  */
-void test(xlen_t start, xlen_t end, bool fast)
+unsigned test(xlen_t start, xlen_t end, bool fast)
 {
-    bool test_whole_range        = !fast || (end - start < 2 * FAST_THRESHOLD);
-    unsigned (*size_gen_w)(void) = fast ? constant_size : iterative_size;
-    unsigned (*size_gen_r)(void) = fast ? constant_size : iterative_size_squared;
+    bool test_whole_range                = !fast || (end - start < 2 * FAST_THRESHOLD);
+    unsigned (*size_gen_w)(size_t index) = fast ? constant_size : iterative_size;
+    unsigned (*size_gen_r)(size_t index) = fast ? constant_size : iterative_size_squared;
+    unsigned read_errors                 = 0;
 
     if (test_whole_range)
     {
-        iterate_range(start, end, write_test, size_gen_w);
+        iterate_range(start, end, size_gen_w, false);
     }
     else
     {
-        iterate_range(start, start + FAST_THRESHOLD, write_test, size_gen_w);
-        iterate_range(end - FAST_THRESHOLD, end, write_test, size_gen_w);
+        iterate_range(start, start + FAST_THRESHOLD, size_gen_w, false);
+        iterate_range(end - FAST_THRESHOLD, end, size_gen_w, false);
     }
 
 #ifdef TARGET_HAS_CACHE
-    // Flush and invalidate caches
-    bm_dcache_invalidate_all();
+    // Flush and invalidate caches of all harts
+    bm_hart_execute_all(invalidate_caches);
 #endif
 
     if (test_whole_range)
     {
-        iterate_range(start, end, read_test, size_gen_r);
+        read_errors += iterate_range(start, end, size_gen_r, true);
     }
     else
     {
-        iterate_range(start, start + FAST_THRESHOLD, read_test, size_gen_r);
-        iterate_range(end - FAST_THRESHOLD, end, read_test, size_gen_r);
+        read_errors += iterate_range(start, start + FAST_THRESHOLD, size_gen_r, true);
+        read_errors += iterate_range(end - FAST_THRESHOLD, end, size_gen_r, true);
     }
+
+    return read_errors;
 }
 
 int main(void)
 {
-    printf("Testing memory range from 0x%llx to 0x%llx, mode: %s.\n",
+    printf("Testing memory range from 0x%llx to 0x%llx on %u harts, mode: %s.\n",
            (unsigned long long)TEST_START,
            (unsigned long long)TEST_END,
+           TARGET_NUM_HARTS,
            TEST_FAST ? "fast" : "normal");
 
     if (program_data_start < (xlen_t)TEST_END && (xlen_t)TEST_START < program_data_end)
@@ -287,12 +398,20 @@ int main(void)
     bm_tcm_dtcm_enable();
 #endif
 
-    // Initialize exception handling
-    bm_interrupt_init(BM_PRIV_MODE_MACHINE);
+    bm_mutex_init(&print_mutex);
+
+    // Initialize exception handling on all harts, each has its own trap save area
     bm_exception_set_handler(BM_EXCEPTION_LAF, mem_error_handler);
     bm_exception_set_handler(BM_EXCEPTION_SAF, mem_error_handler);
+    bm_hart_execute_all(init_exceptions);
+
+    unsigned read_errors = test((xlen_t)TEST_START, (xlen_t)TEST_END, TEST_FAST);
+    unsigned error_count = total_errors();
 
-    test((xlen_t)TEST_START, (xlen_t)TEST_END, TEST_FAST);
+    if (error_count != 0)
+    {
+        printf("Found %u errors, %u of them on read.\n", error_count, read_errors);
+    }
 
     printf("Test %s\n", error_count == 0 ? "passed." : "failed!");
 
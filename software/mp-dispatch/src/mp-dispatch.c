@@ -0,0 +1,114 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <baremetal/common.h>
+#include <baremetal/mp.h>
+#include <baremetal/time.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ITERATIONS 1000
+#define BUFFER_SIZE    (64 * 1024)
+
+static volatile uint32_t buffer[BUFFER_SIZE / sizeof(uint32_t)];
+
+/**
+ * \brief Empty job, only the dispatch overhead is measured
+ */
+void empty_job(bm_hart_func_arg_t arg UNUSED) {}
+
+/**
+ * \brief Measure round-trip latency of starting and joining an empty job on given hart
+ *
+ * \param hart_id ID of the hart to dispatch the job to
+ */
+void measure_dispatch(unsigned hart_id)
+{
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    uint64_t sum = 0;
+
+    // Let the hart pick up the current park mode
+    bm_hart_start(hart_id, empty_job, NULL);
+    bm_hart_join(hart_id);
+
+    for (unsigned i = 0; i < NUM_ITERATIONS; ++i)
+    {
+        uint64_t start = bm_get_cycles();
+
+        bm_hart_start(hart_id, empty_job, NULL);
+        bm_hart_join(hart_id);
+
+        uint64_t cycles = bm_get_cycles() - start;
+
+        min = cycles < min ? cycles : min;
+        max = cycles > max ? cycles : max;
+        sum += cycles;
+    }
+
+    printf("  hart%u: min %6llu, avg %6llu, max %6llu cycles\n",
+           hart_id,
+           (unsigned long long)min,
+           (unsigned long long)(sum / NUM_ITERATIONS),
+           (unsigned long long)max);
+}
+
+/**
+ * \brief Measure duration of a memory-bound loop on the main hart
+ */
+void measure_interference(void)
+{
+    uint64_t start = bm_get_cycles();
+
+    for (unsigned pass = 0; pass < 16; ++pass)
+    {
+        for (size_t i = 0; i < BUFFER_SIZE / sizeof(uint32_t); ++i)
+        {
+            buffer[i] += pass;
+        }
+    }
+
+    printf("  memory loop on hart0: %llu cycles\n", (unsigned long long)(bm_get_cycles() - start));
+}
+
+/**
+ * \brief Run all measurements in given park mode
+ */
+void run(bm_hart_park_mode_t mode, const char *name)
+{
+    bm_hart_set_park_mode(mode);
+    if (bm_hart_get_park_mode() != mode)
+    {
+        printf("Park mode %s is not supported on this target.\n\n", name);
+        return;
+    }
+
+    printf("Park mode %s:\n", name);
+
+    for (unsigned i = 1; i < TARGET_NUM_HARTS; ++i)
+    {
+        measure_dispatch(i);
+    }
+
+    measure_interference();
+    puts("");
+}
+
+int main(void)
+{
+    puts("Welcome to the MP dispatch benchmark!\n");
+
+    if (TARGET_NUM_HARTS < 2)
+    {
+        puts("At least two harts are required, exiting.");
+        return EXIT_SUCCESS;
+    }
+
+    run(BM_HART_PARK_SPIN, "spin");
+    run(BM_HART_PARK_WFI, "WFI");
+
+    puts("Bye.");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <baremetal/csr.h>
+#include <baremetal/interrupt.h>
+#include <baremetal/interrupt_low.h>
+#include <baremetal/pic.h>
+#include <baremetal/time.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_SOURCES (TARGET_PIC_NUM_INTERRUPTS < 128 ? TARGET_PIC_NUM_INTERRUPTS : 128)
+#define NUM_REGS    ((NUM_SOURCES + 31) / 32)
+#define NUM_ROUNDS  100
+
+// Bits of the sources present in the last, possibly partial, flag register and the bit of the highest source
+#define LAST_REG_MASK   (NUM_SOURCES % 32 ? ((uint32_t)1 << (NUM_SOURCES % 32)) - 1 : 0xffffffff)
+#define HIGHEST_REG_BIT ((uint32_t)1 << ((NUM_SOURCES - 1) % 32))
+
+static const bm_csr_id flag_csrs[] = {BM_CSR_MPICFLAG, BM_CSR_MPICFLAG1, BM_CSR_MPICFLAG2, BM_CSR_MPICFLAG3};
+static const bm_csr_id mask_csrs[] = {BM_CSR_MPICMASK, BM_CSR_MPICMASK1, BM_CSR_MPICMASK2, BM_CSR_MPICMASK3};
+
+static volatile unsigned serviced;
+static volatile int      first_serviced;
+
+/**
+ * \brief Reference lookup, reads the CSRs through the generic switch and scans bit by bit
+ */
+int reference_get_irq(void)
+{
+    for (int i = 0; i < NUM_REGS; ++i)
+    {
+        xlen_t enabled = bm_csr_read(flag_csrs[i]) & bm_csr_read(mask_csrs[i]);
+        if (!enabled)
+        {
+            continue;
+        }
+
+        unsigned lsb = i * 32;
+        while (!(enabled & 1))
+        {
+            enabled >>= 1;
+            ++lsb;
+        }
+        return lsb;
+    }
+
+    return -1;
+}
+
+/**
+ * \brief Handler of all sources, counts the serviced interrupts
+ */
+void storm_handler(void)
+{
+    if (serviced++ == 0)
+    {
+        first_serviced = bm_ext_irq_claim();
+    }
+}
+
+/**
+ * \brief Raise all sources, or only the highest one
+ */
+static void raise_sources(bool all)
+{
+    if (all)
+    {
+        for (unsigned i = 0; i < NUM_REGS; ++i)
+        {
+            bm_csr_write(flag_csrs[i], i == NUM_REGS - 1 ? LAST_REG_MASK : 0xffffffff);
+        }
+    }
+    else
+    {
+        bm_csr_set_mask(flag_csrs[NUM_REGS - 1], HIGHEST_REG_BIT);
+    }
+}
+
+/**
+ * \brief Measure draining the raised sources by given lookup function
+ *
+ * \param name Name of the lookup
+ * \param get_irq Lookup function
+ * \param all Raise all sources if true, only the highest one otherwise
+ */
+void measure_lookup(const char *name, int (*get_irq)(void), bool all)
+{
+    uint64_t cycles = 0;
+    unsigned count  = 0;
+
+    for (unsigned round = 0; round < NUM_ROUNDS; ++round)
+    {
+        raise_sources(all);
+
+        uint64_t start = bm_get_cycles();
+
+        int irq;
+        while ((irq = get_irq()) != -1)
+        {
+            bm_pic_clear_irq(irq);
+            ++count;
+        }
+
+        cycles += bm_get_cycles() - start;
+    }
+
+    printf("%-22s %-12s %6llu cycles per interrupt\n",
+           name,
+           all ? "all sources" : "highest only",
+           (unsigned long long)(cycles / count));
+}
+
+/**
+ * \brief Measure servicing all sources by the library external interrupt handler
+ */
+void measure_handler(void)
+{
+    bm_ext_irq_stats_t stats;
+    uint64_t           cycles = 0;
+
+    bm_ext_irq_reset_stats();
+
+    for (unsigned round = 0; round < NUM_ROUNDS; ++round)
+    {
+        serviced = 0;
+        raise_sources(true);
+
+        uint64_t start = bm_get_cycles();
+
+        bm_interrupt_enable(BM_PRIV_MODE_MACHINE);
+        while (serviced < NUM_SOURCES)
+        {
+        }
+        bm_interrupt_disable(BM_PRIV_MODE_MACHINE);
+
+        cycles += bm_get_cycles() - start;
+    }
+
+    bm_ext_irq_get_stats(&stats);
+
+    printf("%-35s %6llu cycles per interrupt, %lu interrupts in %lu traps, first serviced %d\n",
+           "Library handler",
+           (unsigned long long)(cycles / (NUM_ROUNDS * NUM_SOURCES)),
+           (unsigned long)stats.irqs,
+           (unsigned long)stats.traps,
+           first_serviced);
+}
+
+int main(void)
+{
+    puts("Welcome to the PIC interrupt storm benchmark!\n");
+    printf("Raising %u PIC sources %u times.\n\n", NUM_SOURCES, NUM_ROUNDS);
+
+    // The lookups are measured with interrupts disabled, the handler is enabled only by measure_handler
+    bm_interrupt_init(BM_PRIV_MODE_MACHINE);
+    bm_interrupt_disable(BM_PRIV_MODE_MACHINE);
+    bm_interrupt_enable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MEIP);
+
+    for (unsigned i = 0; i < NUM_SOURCES; ++i)
+    {
+        bm_ext_irq_set_handler(i, storm_handler);
+        bm_ext_irq_enable(i);
+    }
+
+    measure_lookup("Reference lookup", reference_get_irq, true);
+    measure_lookup("Reference lookup", reference_get_irq, false);
+    measure_lookup("bm_pic_get_irq", bm_pic_get_irq, true);
+    measure_lookup("bm_pic_get_irq", bm_pic_get_irq, false);
+
+    // The upper half of the sources preempts the lower half
+    for (unsigned i = NUM_SOURCES / 2; i < NUM_SOURCES; ++i)
+    {
+        bm_pic_set_priority(i, BM_PIC_NUM_PRIORITIES - 1);
+    }
+
+    measure_lookup("Priority lookup", bm_pic_get_irq_by_priority, true);
+    measure_lookup("Priority lookup", bm_pic_get_irq_by_priority, false);
+    puts("");
+
+    measure_handler();
+
+    for (unsigned i = 0; i < NUM_SOURCES; ++i)
+    {
+        bm_pic_set_priority(i, 0);
+        bm_ext_irq_disable(i);
+    }
+    bm_interrupt_disable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MEIP);
+
+    puts("\nBye.");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <baremetal/gpio.h>
+#include <baremetal/interrupt.h>
+#include <baremetal/interrupt_low.h>
+#include <baremetal/platform.h>
+#include <baremetal/time.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_SAMPLES     100
+#define LOW_PRIORITY    1
+#define HIGH_PRIORITY   2
+#define LOW_BUSY_CYCLES 100000 // Duration of the low priority handler
+
+static bm_gpio_t *gpio_low;
+static bm_gpio_t *gpio_high;
+
+static volatile uint64_t trigger_cycles;
+static volatile uint64_t entry_cycles;
+static volatile bool     low_done;
+static volatile bool     high_done;
+static volatile bool     preempted;
+
+/**
+ * \brief Long running handler of the low priority interrupt, triggers the high priority one
+ */
+void low_handler(void)
+{
+    bm_gpio_clear_irq(gpio_low);
+
+    trigger_cycles = bm_get_cycles();
+    bm_gpio_set_irq(gpio_high);
+
+    while (bm_get_cycles() - trigger_cycles < LOW_BUSY_CYCLES)
+    {
+    }
+
+    preempted = high_done;
+    low_done  = true;
+}
+
+/**
+ * \brief Handler of the high priority interrupt, samples the entry time
+ */
+void high_handler(void)
+{
+    entry_cycles = bm_get_cycles();
+
+    bm_gpio_clear_irq(gpio_high);
+    high_done = true;
+}
+
+/**
+ * \brief Measure latency of the high priority interrupt while the low priority handler runs
+ *
+ * \param nested Run the handlers in nested mode
+ */
+void measure(bool nested)
+{
+    uint64_t min         = UINT64_MAX;
+    uint64_t max         = 0;
+    uint64_t sum         = 0;
+    unsigned preemptions = 0;
+
+    bm_ext_irq_set_nested(nested);
+
+    for (unsigned i = 0; i < NUM_SAMPLES; ++i)
+    {
+        low_done  = false;
+        high_done = false;
+
+        bm_gpio_set_irq(gpio_low);
+        while (!low_done || !high_done)
+        {
+        }
+
+        uint64_t latency = entry_cycles - trigger_cycles;
+
+        min = latency < min ? latency : min;
+        max = latency > max ? latency : max;
+        sum += latency;
+        preemptions += preempted;
+    }
+
+    printf("%-16s min %7llu, avg %7llu, max %7llu cycles, preempted %u/%u\n",
+           nested ? "Nested mode" : "Default mode",
+           (unsigned long long)min,
+           (unsigned long long)(sum / NUM_SAMPLES),
+           (unsigned long long)max,
+           preemptions,
+           NUM_SAMPLES);
+}
+
+int main(void)
+{
+    puts("Welcome to the PLIC nested interrupts demo!\n");
+
+    gpio_low  = (bm_gpio_t *)target_peripheral_get(BM_PERIPHERAL_GPIO_LEDS_SWITCHES);
+    gpio_high = (bm_gpio_t *)target_peripheral_get(BM_PERIPHERAL_GPIO_SD);
+
+    bm_gpio_init_irq(gpio_low);
+    bm_gpio_init_irq(gpio_high);
+
+    bm_interrupt_init(BM_PRIV_MODE_MACHINE);
+
+    bm_ext_irq_set_handler(gpio_low->ext_irq_id, low_handler);
+    bm_ext_irq_set_handler(gpio_high->ext_irq_id, high_handler);
+    bm_ext_irq_set_priority(gpio_low->ext_irq_id, LOW_PRIORITY);
+    bm_ext_irq_set_priority(gpio_high->ext_irq_id, HIGH_PRIORITY);
+    bm_ext_irq_set_threshold(0);
+    bm_ext_irq_enable(gpio_low->ext_irq_id);
+    bm_ext_irq_enable(gpio_high->ext_irq_id);
+    bm_interrupt_enable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MEIP);
+
+    printf("Latency of the high priority interrupt triggered by a %u cycle low priority handler:\n\n",
+           LOW_BUSY_CYCLES);
+
+    measure(false);
+    measure(true);
+
+    bm_ext_irq_set_nested(false);
+    bm_ext_irq_disable(gpio_low->ext_irq_id);
+    bm_ext_irq_disable(gpio_high->ext_irq_id);
+    bm_interrupt_disable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MEIP);
+
+    puts("\nBye.");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <baremetal/common.h>
+#include <baremetal/console.h>
+#include <baremetal/log.h>
+#include <baremetal/time.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <tiny_printf/printf.h>
+#include <unistd.h>
+
+// The tiny printf is called explicitly as printf_, printf stays the newlib one
+#undef printf
+
+#define NUM_LINES    32
+#define NUM_PRINTERS 4
+#define FORMAT       "%-14s line %2u: value 0x%08x, %10u\n"
+
+/** \brief Printing function under test */
+typedef enum {
+    PRINTER_TINY,
+    PRINTER_NEWLIB,
+    PRINTER_WRITE,
+    PRINTER_WRITEV,
+} printer_t;
+
+/** \brief Result of a single measurement */
+typedef struct {
+    uint64_t cycles;
+    unsigned chars;
+    unsigned outputs;
+} result_t;
+
+static const char *buffering_names[] = {"unbuffered", "line buffered", "fully buffered"};
+static const char *printer_names[]   = {"tiny printf_", "newlib fprintf", "write x4", "bm_console_writev"};
+
+static result_t results[3][NUM_PRINTERS];
+static uint64_t log_cycles;
+
+/**
+ * \brief Output a line preformatted into segments, either by separate writes or by a single gathering write
+ *
+ * \param line Number of the line
+ * \param gather Use bm_console_writev if true, write otherwise
+ *
+ * \return Number of characters written
+ */
+unsigned write_segments(unsigned line, bool gather)
+{
+    static const char digits[] = "0123456789";
+    char              number[2] = {digits[line / 10 % 10], digits[line % 10]};
+
+    bm_console_iovec_t iov[4] = {
+        {"segmented", 9},
+        {" line ", 6},
+        {number, 2},
+        {"\n", 1},
+    };
+
+    if (gather)
+    {
+        bm_console_writev(STDOUT_FILENO, iov, 4);
+    }
+    else
+    {
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            write(STDOUT_FILENO, iov[i].base, iov[i].len);
+        }
+    }
+
+    return 18;
+}
+
+/**
+ * \brief Print a block of lines and measure its duration
+ *
+ * \param buffering Buffering policy of the console
+ * \param printer Printing function to use
+ */
+void measure(bm_console_buffering_t buffering, printer_t printer)
+{
+    unsigned chars = 0;
+
+    bm_console_set_buffering(buffering);
+
+    unsigned outputs = bm_console_get_output_count();
+    uint64_t start   = bm_get_cycles();
+
+    for (unsigned i = 0; i < NUM_LINES; ++i)
+    {
+        uint32_t value = i * 2654435761u;
+
+        switch (printer)
+        {
+            case PRINTER_TINY:
+                chars += printf_(FORMAT, buffering_names[buffering], i, value, value);
+                break;
+            case PRINTER_NEWLIB:
+                chars += fprintf(stdout, FORMAT, buffering_names[buffering], i, value, value);
+                break;
+            case PRINTER_WRITE:
+                chars += write_segments(i, false);
+                break;
+            case PRINTER_WRITEV:
+                chars += write_segments(i, true);
+                break;
+        }
+    }
+    bm_console_flush();
+
+    results[buffering][printer].cycles  = bm_get_cycles() - start;
+    results[buffering][printer].chars   = chars;
+    results[buffering][printer].outputs = bm_console_get_output_count() - outputs;
+}
+
+/**
+ * \brief Record the same lines by the deferred log and measure the cost of the recording only
+ *
+ * The log is drained after each record, outside of the measured interval.
+ */
+void measure_log(void)
+{
+    log_cycles = 0;
+
+    for (unsigned i = 0; i < NUM_LINES; ++i)
+    {
+        uint32_t value = i * 2654435761u;
+
+        uint64_t start = bm_get_cycles();
+        bm_log(FORMAT, (xlen_t)buffering_names[0], i, value, value);
+        log_cycles += bm_get_cycles() - start;
+
+        bm_log_flush();
+    }
+}
+
+int main(void)
+{
+    puts("Welcome to the printf throughput benchmark!\n");
+
+    // Let newlib pass each formatted string to the console, so that only the console buffering is measured
+    fflush(stdout);
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    for (unsigned buffering = 0; buffering < 3; ++buffering)
+    {
+        for (unsigned printer = 0; printer < NUM_PRINTERS; ++printer)
+        {
+            measure((bm_console_buffering_t)buffering, (printer_t)printer);
+        }
+    }
+
+    bm_console_set_buffering(BM_CONSOLE_LINE_BUFFERED);
+    measure_log();
+
+    printf("\nConsole backend %s, buffer size %u bytes, %u lines per measurement:\n",
+           bm_console_backend,
+           BM_CONSOLE_BUFFER_SIZE,
+           NUM_LINES);
+
+    for (unsigned buffering = 0; buffering < 3; ++buffering)
+    {
+        for (unsigned printer = 0; printer < NUM_PRINTERS; ++printer)
+        {
+            const result_t *result = &results[buffering][printer];
+
+            printf("  %-14s %-17s %10llu cycles, %8llu cycles/line, %6llu cycles/char, %4u backend calls\n",
+                   buffering_names[buffering],
+                   printer_names[printer],
+                   (unsigned long long)result->cycles,
+                   (unsigned long long)(result->cycles / NUM_LINES),
+                   (unsigned long long)(result->cycles / result->chars),
+                   result->outputs);
+        }
+    }
+
+    printf("  %-32s %10llu cycles, %8llu cycles/line (recording only, decode by share/bmlog.py)\n",
+           "deferred bm_log",
+           (unsigned long long)log_cycles,
+           (unsigned long long)(log_cycles / NUM_LINES));
+
+#ifdef TARGET_SIMULATION
+    puts("\nThe time spent by the simulator in the traps is not included in the cycle counts, the number\n"
+         "of backend calls shows the actual cost of the output.");
+#endif
+
+    puts("\nBye.");
+    return EXIT_SUCCESS;
+}
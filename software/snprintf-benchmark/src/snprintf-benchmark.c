@@ -0,0 +1,124 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include <baremetal/time.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tiny_printf/printf.h>
+
+// The tiny printf is called explicitly as snprintf_, printf stays the newlib one
+#undef printf
+#undef snprintf
+
+#define NUM_CALLS 256
+
+// Build profile of the tiny printf, selected by CONFIG_PRINTF_PROFILE
+#if defined(PRINTF_SUPPORT_FLOAT)
+    #define PRINTF_PROFILE "FULL"
+#elif defined(PRINTF_DISABLE_SUPPORT_LONG_LONG)
+    #define PRINTF_PROFILE "MINIMAL"
+#else
+    #define PRINTF_PROFILE "DEFAULT"
+#endif
+
+/** \brief Formatting under test */
+typedef struct {
+    const char *name;
+    int (*format)(char *buffer, size_t size, uint32_t value);
+} benchmark_t;
+
+static int format_small(char *buffer, size_t size, uint32_t value)
+{
+    return snprintf_(buffer, size, "%u", (unsigned)(value % 100));
+}
+
+static int format_unsigned(char *buffer, size_t size, uint32_t value)
+{
+    return snprintf_(buffer, size, "%u", (unsigned)value);
+}
+
+static int format_signed(char *buffer, size_t size, uint32_t value)
+{
+    return snprintf_(buffer, size, "%d", (int)(int32_t)value);
+}
+
+static int format_hex(char *buffer, size_t size, uint32_t value)
+{
+    return snprintf_(buffer, size, "%08x", (unsigned)value);
+}
+
+static int format_long_long(char *buffer, size_t size, uint32_t value)
+{
+    return snprintf_(buffer, size, "%llu", value * 0x9e3779b97f4a7c15ull);
+}
+
+static int format_log_line(char *buffer, size_t size, uint32_t value)
+{
+    return snprintf_(buffer, size, "%-8s %5u: 0x%08x %10u\n", "event", (unsigned)(value % 10000), value, value);
+}
+
+#ifdef PRINTF_SUPPORT_FLOAT
+static int format_float(char *buffer, size_t size, uint32_t value)
+{
+    return snprintf_(buffer, size, "%.3f", value / 1000.0);
+}
+#endif
+
+static const benchmark_t benchmarks[] = {
+    {"%u (2 digits)", format_small},
+    {"%u", format_unsigned},
+    {"%d", format_signed},
+    {"%08x", format_hex},
+    {"%llu", format_long_long},
+    {"log line", format_log_line},
+#ifdef PRINTF_SUPPORT_FLOAT
+    {"%.3f", format_float},
+#endif
+};
+
+/**
+ * \brief Measure the formatting of pseudo-random values into a buffer
+ *
+ * \param benchmark Formatting to measure
+ */
+void measure(const benchmark_t *benchmark)
+{
+    char     buffer[64];
+    unsigned chars = 0;
+
+    uint64_t start = bm_get_cycles();
+
+    for (unsigned i = 0; i < NUM_CALLS; ++i)
+    {
+        chars += benchmark->format(buffer, sizeof(buffer), i * 2654435761u);
+    }
+
+    uint64_t cycles = bm_get_cycles() - start;
+
+    // Show the last formatted value without the trailing newline of the log line
+    benchmark->format(buffer, sizeof(buffer), 123456789u);
+    printf("  %-14s %8llu cycles/call, %5llu cycles/char, e.g. \"%.*s\"\n",
+           benchmark->name,
+           (unsigned long long)(cycles / NUM_CALLS),
+           (unsigned long long)(cycles / chars),
+           (int)strcspn(buffer, "\n"),
+           buffer);
+}
+
+int main(void)
+{
+    puts("Welcome to the snprintf benchmark!\n");
+
+    printf("Tiny printf profile %s, %u calls per measurement:\n", PRINTF_PROFILE, NUM_CALLS);
+
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i)
+    {
+        measure(&benchmarks[i]);
+    }
+
+    puts("\nBye.");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,690 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#include "kvstore.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define KV_MAGIC               0x4B56534Cu // "KVSL"
+#define KV_SEQUENCE_FREE       0xFFFFFFFFu
+#define KV_LENGTH_TOMBSTONE    0xFFFE
+#define KV_LENGTH_ERASED       0xFFFF
+
+// The flash corrects errors in 16-byte units, programming a unit twice disables the correction
+#define KV_ALIGN               16
+#define KV_HEADER_SIZE         32 // The erase count and the sequence number are in separate units
+#define KV_SEQUENCE_OFFSET     16
+#define KV_SECTOR_CAPACITY     (KV_SECTOR_SIZE - KV_HEADER_SIZE)
+#define KV_RECORD_HEADER_SIZE  8
+#define KV_MAX_RECORD_SIZE     ((KV_RECORD_HEADER_SIZE + KV_MAX_VALUE_SIZE + KV_ALIGN - 1) & ~(KV_ALIGN - 1))
+
+// Sectors kept free by the background compaction, one of them is reserved for the compaction itself
+#define KV_FREE_TARGET         2
+
+// Difference of the erase counts which triggers moving the data of the least erased sector
+#define KV_WEAR_THRESHOLD      8
+
+/** \brief Header of a sector, the sequence number is programmed when the sector is filled */
+typedef struct {
+    uint32_t magic;       ///< KV_MAGIC
+    uint32_t erase_count; ///< Number of erases of the sector
+    uint32_t reserved[2]; ///< Erased
+    uint32_t sequence;    ///< Order in which the sectors were filled, all ones while free
+} kv_sector_header_t;
+
+/** \brief Header of a record, followed by the value and padded to KV_ALIGN bytes */
+typedef struct {
+    uint32_t key;    ///< Key
+    uint16_t length; ///< Size of the value, KV_LENGTH_TOMBSTONE for a deletion
+    uint16_t crc;    ///< CRC-16 of the key, length and value
+} kv_record_header_t;
+
+/**
+ * \brief Compute CRC-16-CCITT
+ *
+ * \param crc Initial value
+ * \param data Data
+ * \param length Size of the data
+ *
+ * \return Updated CRC
+ */
+static uint16_t kv_crc16(uint16_t crc, const uint8_t *data, size_t length)
+{
+    while (length--)
+    {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (unsigned i = 0; i < 8; ++i)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static inline uint32_t kv_record_size(uint16_t length)
+{
+    uint32_t value_size = length == KV_LENGTH_TOMBSTONE ? 0 : length;
+
+    return (KV_RECORD_HEADER_SIZE + value_size + KV_ALIGN - 1) & ~(KV_ALIGN - 1);
+}
+
+static inline uint32_t kv_sector_address(kv_store_t *kv, unsigned sector)
+{
+    return kv->address + sector * KV_SECTOR_SIZE;
+}
+
+static inline unsigned kv_sector_of(kv_store_t *kv, uint32_t address)
+{
+    return (address - kv->address) / KV_SECTOR_SIZE;
+}
+
+static inline unsigned kv_hash(uint32_t key)
+{
+    return (key * 2654435761u) & (KV_INDEX_SIZE - 1);
+}
+
+/**
+ * \brief Find the index slot of a key, or the empty slot where it would be inserted
+ *
+ * \param kv Store
+ * \param key Key
+ *
+ * \return Slot of the key or an empty slot
+ */
+static unsigned kv_index_find(kv_store_t *kv, uint32_t key)
+{
+    unsigned slot = kv_hash(key);
+
+    while (kv->index[slot].key != key && kv->index[slot].key != KV_KEY_INVALID)
+    {
+        slot = (slot + 1) & (KV_INDEX_SIZE - 1);
+    }
+
+    return slot;
+}
+
+/**
+ * \brief Remove a slot from the index, shifting back the following entries of the probe sequence
+ *
+ * \param kv Store
+ * \param slot Slot to remove
+ */
+static void kv_index_remove(kv_store_t *kv, unsigned slot)
+{
+    unsigned next = slot;
+
+    kv->index[slot].key = KV_KEY_INVALID;
+    kv->num_keys--;
+
+    for (;;)
+    {
+        next = (next + 1) & (KV_INDEX_SIZE - 1);
+
+        if (kv->index[next].key == KV_KEY_INVALID)
+        {
+            return;
+        }
+
+        // The entry can fill the hole unless its home slot lies cyclically between the hole and itself
+        unsigned home = kv_hash(kv->index[next].key);
+        if (((next - home) & (KV_INDEX_SIZE - 1)) >= ((next - slot) & (KV_INDEX_SIZE - 1)))
+        {
+            kv->index[slot]     = kv->index[next];
+            kv->index[next].key = KV_KEY_INVALID;
+            slot                = next;
+        }
+    }
+}
+
+/**
+ * \brief Point the index to a new record of a key and update the live data of the sectors
+ *
+ * \param kv Store
+ * \param key Key
+ * \param address Address of the record
+ * \param size Size of the record
+ * \param deleted The record is a deletion
+ *
+ * \return Zero on success, non-zero if the index is full
+ */
+static int kv_index_update(kv_store_t *kv, uint32_t key, uint32_t address, uint32_t size, bool deleted)
+{
+    kv_entry_t *entry = &kv->index[kv_index_find(kv, key)];
+
+    if (entry->key == KV_KEY_INVALID)
+    {
+        // Keep the probe sequences short
+        if (kv->num_keys >= KV_INDEX_SIZE * 3 / 4)
+        {
+            return -1;
+        }
+
+        entry->key = key;
+        kv->num_keys++;
+    }
+    else
+    {
+        kv->sectors[kv_sector_of(kv, entry->address)].live -= entry->size;
+    }
+
+    entry->address = address;
+    entry->size    = size;
+    entry->deleted = deleted;
+
+    kv->sectors[kv_sector_of(kv, address)].live += size;
+
+    return 0;
+}
+
+static int kv_program(kv_store_t *kv, uint32_t address, const void *data, uint32_t length)
+{
+    kv->stats.flash_bytes += length;
+
+    return flash_page_program(kv->flash, address, length, data);
+}
+
+/**
+ * \brief Erase a sector and write its header with the incremented erase count
+ *
+ * \param kv Store
+ * \param sector Sector to erase
+ *
+ * \return Zero on success non-zero otherwise
+ */
+static int kv_erase_sector(kv_store_t *kv, unsigned sector)
+{
+    kv_sector_t       *state  = &kv->sectors[sector];
+    kv_sector_header_t header = {.magic = KV_MAGIC, .erase_count = state->erase_count + 1};
+
+    kv->stats.erases++;
+
+    if (flash_sector_erase(kv->flash, kv_sector_address(kv, sector)))
+    {
+        return -1;
+    }
+
+    // Only the first unit is programmed, the sequence number stays erased
+    if (kv_program(kv, kv_sector_address(kv, sector), &header, KV_SEQUENCE_OFFSET))
+    {
+        return -1;
+    }
+
+    *state = (kv_sector_t){
+        .erase_count = header.erase_count,
+        .sequence    = KV_SEQUENCE_FREE,
+        .formatted   = true,
+    };
+
+    return 0;
+}
+
+static unsigned kv_count_free(kv_store_t *kv)
+{
+    unsigned count = 0;
+
+    for (unsigned i = 0; i < kv->num_sectors; ++i)
+    {
+        count += kv->sectors[i].sequence == KV_SEQUENCE_FREE;
+    }
+
+    return count;
+}
+
+/**
+ * \brief Start filling the least erased free sector
+ *
+ * \param kv Store
+ *
+ * \return Zero on success non-zero otherwise
+ */
+static int kv_open_sector(kv_store_t *kv)
+{
+    int sector = -1;
+
+    for (unsigned i = 0; i < kv->num_sectors; ++i)
+    {
+        if (kv->sectors[i].sequence == KV_SEQUENCE_FREE &&
+            (sector < 0 || kv->sectors[i].erase_count < kv->sectors[sector].erase_count))
+        {
+            sector = i;
+        }
+    }
+
+    if (sector < 0)
+    {
+        return -1;
+    }
+
+    // The content of a sector without a header is unknown
+    if (!kv->sectors[sector].formatted && kv_erase_sector(kv, sector))
+    {
+        return -1;
+    }
+
+    uint32_t sequence = kv->next_sequence++;
+    if (kv_program(kv, kv_sector_address(kv, sector) + KV_SEQUENCE_OFFSET, &sequence, sizeof(sequence)))
+    {
+        return -1;
+    }
+
+    kv->sectors[sector].sequence = sequence;
+    kv->sectors[sector].used     = 0;
+    kv->sectors[sector].live     = 0;
+    kv->active                   = sector;
+
+    return 0;
+}
+
+/**
+ * \brief Append a record to the active sector and point the index to it
+ *
+ * \param kv Store
+ * \param key Key
+ * \param length Size of the value or KV_LENGTH_TOMBSTONE
+ * \param value Value
+ * \param min_free Number of free sectors which must be left when a new sector is opened
+ *
+ * \return Zero on success non-zero otherwise
+ */
+static int kv_append(kv_store_t *kv, uint32_t key, uint16_t length, const void *value, unsigned min_free)
+{
+    uint8_t  record[KV_MAX_RECORD_SIZE];
+    uint32_t size       = kv_record_size(length);
+    uint32_t value_size = length == KV_LENGTH_TOMBSTONE ? 0 : length;
+
+    if (kv->active < 0 || kv->sectors[kv->active].used + size > KV_SECTOR_CAPACITY)
+    {
+        if (kv_count_free(kv) <= min_free || kv_open_sector(kv))
+        {
+            return -1;
+        }
+    }
+
+    kv_record_header_t header = {.key = key, .length = length};
+
+    memset(record, 0xff, size);
+    memcpy(record, &header, KV_RECORD_HEADER_SIZE);
+    if (value_size > 0)
+    {
+        memcpy(record + KV_RECORD_HEADER_SIZE, value, value_size);
+    }
+
+    // The CRC covers the key, the length and the value
+    header.crc = kv_crc16(0xffff, record, offsetof(kv_record_header_t, crc));
+    header.crc = kv_crc16(header.crc, record + KV_RECORD_HEADER_SIZE, value_size);
+    memcpy(record, &header, KV_RECORD_HEADER_SIZE);
+
+    kv_sector_t *sector  = &kv->sectors[kv->active];
+    uint32_t     address = kv_sector_address(kv, kv->active) + KV_HEADER_SIZE + sector->used;
+
+    if (kv_program(kv, address, record, size))
+    {
+        return -1;
+    }
+
+    sector->used += size;
+
+    return kv_index_update(kv, key, address, size, length == KV_LENGTH_TOMBSTONE);
+}
+
+/**
+ * \brief Read and check a record
+ *
+ * \param kv Store
+ * \param address Address of the record
+ * \param header Header of the record
+ * \param value Buffer of KV_MAX_VALUE_SIZE bytes for the value
+ *
+ * \return 1 if the record is valid, 0 at the end of the records, -1 if the record is corrupted
+ */
+static int kv_read_record(kv_store_t *kv, uint32_t address, kv_record_header_t *header, uint8_t *value)
+{
+    flash_read(kv->flash, address, KV_RECORD_HEADER_SIZE, (uint8_t *)header);
+
+    if (header->key == KV_KEY_INVALID && header->length == KV_LENGTH_ERASED)
+    {
+        return 0;
+    }
+
+    if (header->key == KV_KEY_INVALID ||
+        (header->length > KV_MAX_VALUE_SIZE && header->length != KV_LENGTH_TOMBSTONE))
+    {
+        return -1;
+    }
+
+    uint32_t value_size = header->length == KV_LENGTH_TOMBSTONE ? 0 : header->length;
+    flash_read(kv->flash, address + KV_RECORD_HEADER_SIZE, value_size, value);
+
+    uint16_t crc = kv_crc16(0xffff, (const uint8_t *)header, offsetof(kv_record_header_t, crc));
+    crc          = kv_crc16(crc, value, value_size);
+
+    return crc == header->crc ? 1 : -1;
+}
+
+/**
+ * \brief Copy the live records of a sector to the active one and erase it
+ *
+ * Deletions are only dropped from the oldest sector, as an older record of the key could
+ * otherwise reappear at the next mount.
+ *
+ * \param kv Store
+ * \param sector Sector to compact, must not be the active one
+ *
+ * \return Zero on success non-zero otherwise
+ */
+static int kv_compact(kv_store_t *kv, unsigned sector)
+{
+    uint8_t            value[KV_MAX_VALUE_SIZE];
+    kv_record_header_t header;
+    uint32_t           base   = kv_sector_address(kv, sector) + KV_HEADER_SIZE;
+    bool               oldest = true;
+
+    for (unsigned i = 0; i < kv->num_sectors; ++i)
+    {
+        if (kv->sectors[i].sequence < kv->sectors[sector].sequence)
+        {
+            oldest = false;
+        }
+    }
+
+    for (uint32_t offset = 0; offset < kv->sectors[sector].used; offset += kv_record_size(header.length))
+    {
+        if (kv_read_record(kv, base + offset, &header, value) <= 0)
+        {
+            break;
+        }
+
+        unsigned slot = kv_index_find(kv, header.key);
+        if (kv->index[slot].key != header.key || kv->index[slot].address != base + offset)
+        {
+            continue;
+        }
+
+        if (kv->index[slot].deleted && oldest)
+        {
+            kv->sectors[sector].live -= kv->index[slot].size;
+            kv_index_remove(kv, slot);
+        }
+        else if (kv_append(kv, header.key, header.length, value, 0))
+        {
+            return -1;
+        }
+    }
+
+    kv->stats.compactions++;
+
+    return kv_erase_sector(kv, sector);
+}
+
+/**
+ * \brief Choose the filled sector with the least live data
+ *
+ * \param kv Store
+ *
+ * \return Sector to compact, or -1 if no sector has any space to reclaim
+ */
+static int kv_pick_victim(kv_store_t *kv)
+{
+    int victim = -1;
+
+    for (unsigned i = 0; i < kv->num_sectors; ++i)
+    {
+        kv_sector_t *state = &kv->sectors[i];
+
+        if (state->sequence == KV_SEQUENCE_FREE || (int)i == kv->active || state->live >= state->used)
+        {
+            continue;
+        }
+
+        if (victim < 0 || state->live < kv->sectors[victim].live)
+        {
+            victim = i;
+        }
+    }
+
+    return victim;
+}
+
+/**
+ * \brief Make sure a new sector can be opened by a user write
+ *
+ * \param kv Store
+ * \param size Size of the record to write
+ *
+ * \return Zero on success, non-zero if the store is full
+ */
+static int kv_reserve(kv_store_t *kv, uint32_t size)
+{
+    if (kv->active >= 0 && kv->sectors[kv->active].used + size <= KV_SECTOR_CAPACITY)
+    {
+        return 0;
+    }
+
+    while (kv_count_free(kv) < KV_FREE_TARGET)
+    {
+        int victim = kv_pick_victim(kv);
+
+        if (victim < 0 || kv_compact(kv, victim))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int kv_mount(kv_store_t *kv, spi_flash_t *flash, uint32_t address, unsigned num_sectors)
+{
+    uint8_t  value[KV_MAX_VALUE_SIZE];
+    unsigned order[KV_MAX_SECTORS];
+    unsigned num_used = 0;
+
+    if (num_sectors < KV_FREE_TARGET + 1 || num_sectors > KV_MAX_SECTORS)
+    {
+        return -1;
+    }
+
+    memset(kv, 0, sizeof(*kv));
+    kv->flash       = flash;
+    kv->address     = address;
+    kv->num_sectors = num_sectors;
+    kv->active      = -1;
+
+    for (unsigned i = 0; i < KV_INDEX_SIZE; ++i)
+    {
+        kv->index[i].key = KV_KEY_INVALID;
+    }
+
+    // Read the sector headers and sort the filled sectors by their sequence numbers
+    for (unsigned i = 0; i < num_sectors; ++i)
+    {
+        kv_sector_header_t header;
+
+        flash_read(flash, kv_sector_address(kv, i), sizeof(header), (uint8_t *)&header);
+
+        kv->sectors[i].formatted   = header.magic == KV_MAGIC;
+        kv->sectors[i].erase_count = kv->sectors[i].formatted ? header.erase_count : 0;
+        kv->sectors[i].sequence    = kv->sectors[i].formatted ? header.sequence : KV_SEQUENCE_FREE;
+
+        if (kv->sectors[i].sequence == KV_SEQUENCE_FREE)
+        {
+            continue;
+        }
+
+        unsigned pos = num_used++;
+        while (pos > 0 && kv->sectors[order[pos - 1]].sequence > header.sequence)
+        {
+            order[pos] = order[pos - 1];
+            pos--;
+        }
+        order[pos] = i;
+
+        if (header.sequence >= kv->next_sequence)
+        {
+            kv->next_sequence = header.sequence + 1;
+        }
+    }
+
+    // Replay the records from the oldest to the newest
+    for (unsigned i = 0; i < num_used; ++i)
+    {
+        kv_sector_t       *state = &kv->sectors[order[i]];
+        uint32_t           base  = kv_sector_address(kv, order[i]) + KV_HEADER_SIZE;
+        kv_record_header_t header;
+        int                result = 1;
+
+        while (state->used + KV_RECORD_HEADER_SIZE <= KV_SECTOR_CAPACITY &&
+               (result = kv_read_record(kv, base + state->used, &header, value)) > 0)
+        {
+            uint32_t size = kv_record_size(header.length);
+
+            if (state->used + size > KV_SECTOR_CAPACITY)
+            {
+                result = -1;
+                break;
+            }
+
+            if (kv_index_update(kv, header.key, base + state->used, size, header.length == KV_LENGTH_TOMBSTONE))
+            {
+                return -1;
+            }
+            state->used += size;
+        }
+
+        // Nothing is appended after a corrupted record, e.g. an interrupted write
+        if (result < 0)
+        {
+            state->used = KV_SECTOR_CAPACITY;
+        }
+
+        kv->active = order[i];
+    }
+
+    return 0;
+}
+
+int kv_format(kv_store_t *kv)
+{
+    for (unsigned i = 0; i < kv->num_sectors; ++i)
+    {
+        // Free sectors with a header are still erased
+        if (kv->sectors[i].sequence != KV_SEQUENCE_FREE && kv_erase_sector(kv, i))
+        {
+            return -1;
+        }
+    }
+
+    for (unsigned i = 0; i < KV_INDEX_SIZE; ++i)
+    {
+        kv->index[i].key = KV_KEY_INVALID;
+    }
+
+    kv->num_keys = 0;
+    kv->active   = -1;
+
+    return 0;
+}
+
+int kv_set(kv_store_t *kv, uint32_t key, const void *value, size_t length)
+{
+    if (key == KV_KEY_INVALID || length > KV_MAX_VALUE_SIZE)
+    {
+        return -1;
+    }
+
+    if (kv_reserve(kv, kv_record_size(length)))
+    {
+        return -1;
+    }
+
+    kv->stats.user_bytes += sizeof(key) + length;
+
+    return kv_append(kv, key, length, value, KV_FREE_TARGET - 1);
+}
+
+int kv_get(kv_store_t *kv, uint32_t key, void *value, size_t size)
+{
+    kv_entry_t *entry = &kv->index[kv_index_find(kv, key)];
+
+    if (entry->key == KV_KEY_INVALID || entry->deleted)
+    {
+        return -1;
+    }
+
+    kv_record_header_t header;
+    flash_read(kv->flash, entry->address, KV_RECORD_HEADER_SIZE, (uint8_t *)&header);
+    flash_read(kv->flash, entry->address + KV_RECORD_HEADER_SIZE, header.length < size ? header.length : size, value);
+
+    return header.length;
+}
+
+int kv_delete(kv_store_t *kv, uint32_t key)
+{
+    kv_entry_t *entry = &kv->index[kv_index_find(kv, key)];
+
+    if (entry->key == KV_KEY_INVALID || entry->deleted)
+    {
+        return 0;
+    }
+
+    if (kv_reserve(kv, kv_record_size(KV_LENGTH_TOMBSTONE)))
+    {
+        return -1;
+    }
+
+    kv->stats.user_bytes += sizeof(key);
+
+    return kv_append(kv, key, KV_LENGTH_TOMBSTONE, NULL, KV_FREE_TARGET - 1);
+}
+
+int kv_compact_step(kv_store_t *kv)
+{
+    int victim = -1;
+
+    // One more than kv_set needs, so that the next sector switch of kv_set does not compact
+    if (kv_count_free(kv) < KV_FREE_TARGET + 1)
+    {
+        victim = kv_pick_victim(kv);
+    }
+
+    // Move the data of the least erased sector, so that the sector gets reused
+    if (victim < 0 && kv_count_free(kv) >= KV_FREE_TARGET)
+    {
+        unsigned min = 0;
+        unsigned max = 0;
+
+        for (unsigned i = 1; i < kv->num_sectors; ++i)
+        {
+            if (kv->sectors[i].erase_count < kv->sectors[min].erase_count)
+            {
+                min = i;
+            }
+            if (kv->sectors[i].erase_count > kv->sectors[max].erase_count)
+            {
+                max = i;
+            }
+        }
+
+        if (kv->sectors[max].erase_count - kv->sectors[min].erase_count > KV_WEAR_THRESHOLD &&
+            kv->sectors[min].sequence != KV_SEQUENCE_FREE && (int)min != kv->active)
+        {
+            victim = min;
+        }
+    }
+
+    if (victim < 0)
+    {
+        return 0;
+    }
+
+    return kv_compact(kv, victim) ? -1 : 1;
+}
+
+void kv_get_stats(kv_store_t *kv, kv_stats_t *stats)
+{
+    *stats = kv->stats;
+}
@@ -0,0 +1,148 @@
+/* Copyright 2024 Codasip s.r.o.         */
+/* SPDX-License-Identifier: BSD-3-Clause */
+
+#ifndef CODASIP_KVSTORE_H
+#define CODASIP_KVSTORE_H
+
+#include "s25fl128s.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KV_SECTOR_SIZE     4096 // Size of the erase sector
+#define KV_MAX_SECTORS     32   // Maximum number of sectors of a store
+#define KV_INDEX_SIZE      256  // Number of slots of the in-RAM index, a power of two
+#define KV_MAX_VALUE_SIZE  240  // Maximum size of a value in bytes
+#define KV_KEY_INVALID     0xFFFFFFFF
+
+/** \brief Entry of the in-RAM index */
+typedef struct {
+    uint32_t key;     ///< Key, KV_KEY_INVALID if the slot is empty
+    uint32_t address; ///< Address of the latest record of the key
+    uint16_t size;    ///< Size of the record in flash
+    bool     deleted; ///< The latest record is a deletion
+} kv_entry_t;
+
+/** \brief State of a sector */
+typedef struct {
+    uint32_t erase_count; ///< Number of erases of the sector
+    uint32_t sequence;    ///< Order in which the sectors were filled, all ones if the sector is free
+    uint32_t used;        ///< Bytes of records written to the sector
+    uint32_t live;        ///< Bytes of records not superseded by a later one
+    bool     formatted;   ///< The sector holds a header with the erase count
+} kv_sector_t;
+
+/** \brief Statistics of the store */
+typedef struct {
+    uint32_t user_bytes;  ///< Bytes of keys and values written by the user
+    uint32_t flash_bytes; ///< Bytes programmed to the flash, including the copies and headers
+    uint32_t erases;      ///< Number of sector erases
+    uint32_t compactions; ///< Number of compacted sectors
+} kv_stats_t;
+
+/** \brief Log-structured key-value store in a range of erase sectors of the flash */
+typedef struct {
+    spi_flash_t *flash;                    ///< Flash device
+    uint32_t     address;                  ///< Address of the first sector
+    unsigned     num_sectors;              ///< Number of sectors
+    int          active;                   ///< Sector the records are appended to, -1 if none
+    uint32_t     next_sequence;            ///< Sequence number of the next sector to fill
+    unsigned     num_keys;                 ///< Number of occupied index slots
+    kv_sector_t  sectors[KV_MAX_SECTORS];  ///< State of the sectors
+    kv_entry_t   index[KV_INDEX_SIZE];     ///< Location of the latest record of each key
+    kv_stats_t   stats;                    ///< Statistics
+} kv_store_t;
+
+/**
+ * \brief Mount the store, rebuilding the index from the records in the flash
+ *
+ * The sectors must be 4 KB parameter sectors, which are erased by flash_sector_erase. Sectors
+ * without a valid header are formatted when first used.
+ *
+ * \param kv Store to mount
+ * \param flash Flash device
+ * \param address Address of the first sector
+ * \param num_sectors Number of sectors, at least 3 and at most KV_MAX_SECTORS
+ *
+ * \return Zero on success non-zero otherwise
+ */
+int kv_mount(kv_store_t *kv, spi_flash_t *flash, uint32_t address, unsigned num_sectors);
+
+/**
+ * \brief Erase all data of the store, keeping the erase counts of the sectors
+ *
+ * \param kv Mounted store
+ *
+ * \return Zero on success non-zero otherwise
+ */
+int kv_format(kv_store_t *kv);
+
+/**
+ * \brief Set the value of a key
+ *
+ * The record is appended to the active sector. When no free sector is left besides the one
+ * reserved for compaction, the sector with the least live data is compacted first.
+ *
+ * \param kv Mounted store
+ * \param key Key, any value except KV_KEY_INVALID
+ * \param value Value to store
+ * \param length Size of the value, at most KV_MAX_VALUE_SIZE
+ *
+ * \return Zero on success non-zero otherwise, e.g. if the store is full
+ */
+int kv_set(kv_store_t *kv, uint32_t key, const void *value, size_t length);
+
+/**
+ * \brief Get the value of a key
+ *
+ * \param kv Mounted store
+ * \param key Key
+ * \param value Buffer to store the value in
+ * \param size Size of the buffer, a longer value is truncated
+ *
+ * \return Size of the value, or -1 if the key is not present
+ */
+int kv_get(kv_store_t *kv, uint32_t key, void *value, size_t size);
+
+/**
+ * \brief Delete a key
+ *
+ * \param kv Mounted store
+ * \param key Key
+ *
+ * \return Zero on success non-zero otherwise
+ */
+int kv_delete(kv_store_t *kv, uint32_t key);
+
+/**
+ * \brief Do a step of the background maintenance
+ *
+ * Compacts a sector if fewer than three free sectors are left, so that kv_set can open its next
+ * sector without compacting, as it keeps one free sector reserved for the compaction, or
+ * moves the data of the least erased sector if the erase counts differ too much (wear leveling).
+ * Intended to be called when the application is idle.
+ *
+ * \param kv Mounted store
+ *
+ * \return 1 if a sector was compacted, 0 if there was nothing to do, negative value on error
+ */
+int kv_compact_step(kv_store_t *kv);
+
+/**
+ * \brief Get the statistics of the store
+ *
+ * \param kv Mounted store
+ * \param stats Structure to fill
+ */
+void kv_get_stats(kv_store_t *kv, kv_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CODASIP_KVSTORE_H
@@ -3,12 +3,15 @@
 
 #include "s25fl128s.h"
 
+#include <baremetal/time.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define FLASH_STATUS_WIP        0x1  // Work in progress
 #define FLASH_STATUS_E_ERR      0x20 // Erase error
 #define FLASH_STATUS_P_ERR      0x40 // Programming error
+#define FLASH_CONFIG_QUAD       0x2  // Quad mode
 #define FLASH_ERASE_SECTOR_SIZE 4096
 #define FLASH_PAGE_PROGRAM_SIZE 256
 
@@ -19,11 +22,28 @@
 #define FLASH_OP_4PP            0x12 // Page Programming
 #define FLASH_OP_4QPP           0x34 // Quad Page Programming
 #define FLASH_OP_4READ          0x13 // Read Data bytes
+#define FLASH_OP_4FAST_READ     0x0C // Read Data bytes at Fast Speed
 #define FLASH_OP_4DOR           0x3C // Read Dual Out
 #define FLASH_OP_4QOR           0x6C // Read Quad Out
 #define FLASH_OP_4P4E           0x21 // 4 KB Parameter Sector Erase
+#define FLASH_OP_CLSR           0x30 // Clear Status Register
 #define FLASH_OP_RST            0xF0 // Software Reset
 
+// Intervals between the status reads of the jobs, a fraction of the typical duration
+#define FLASH_ERASE_POLL_US     1000 // Typical 4 KB sector erase time is 130 ms
+#define FLASH_PROGRAM_POLL_US   50   // Typical page program time is 250 us
+
+/** \brief Command and dummy bytes of the read modes */
+static const struct {
+    uint8_t op;          ///< Command
+    uint8_t dummy_bytes; ///< Bytes written for the 8 dummy cycles, the IP clocks them on the data lanes
+} flash_read_cmds[] = {
+    [FLASH_READ_NORMAL] = {FLASH_OP_4READ,      0},
+    [FLASH_READ_FAST]   = {FLASH_OP_4FAST_READ, 1},
+    [FLASH_READ_DUAL]   = {FLASH_OP_4DOR,       2},
+    [FLASH_READ_QUAD]   = {FLASH_OP_4QOR,       4},
+};
+
 static inline void flash_cmd_set_op(spi_flash_t *flash, uint8_t op)
 {
     bm_spi_write_byte(flash->spi, op);
@@ -41,15 +61,20 @@ static inline void flash_cmd_set_address(spi_flash_t *flash, uint32_t address)
     bm_spi_txrx_bufs(flash->spi, address_buffer, NULL, 4);
 }
 
-static inline uint32_t flash_get_status(spi_flash_t *flash)
+static inline uint32_t flash_read_register(spi_flash_t *flash, uint8_t op)
 {
     bm_spi_cs_assert(flash->spi);
 
-    flash_cmd_set_op(flash, FLASH_OP_RDSR);
-    uint32_t status = bm_spi_read_byte(flash->spi);
+    flash_cmd_set_op(flash, op);
+    uint32_t value = bm_spi_read_byte(flash->spi);
 
     bm_spi_cs_deassert(flash->spi);
-    return status;
+    return value;
+}
+
+static inline uint32_t flash_get_status(spi_flash_t *flash)
+{
+    return flash_read_register(flash, FLASH_OP_RDSR);
 }
 
 static inline void flash_simple_cmd(spi_flash_t *flash, unsigned command)
@@ -63,9 +88,70 @@ static inline void flash_simple_cmd(spi_flash_t *flash, unsigned command)
         ;
 }
 
-int flash_sector_erase(spi_flash_t *flash, uint32_t address)
+static inline void flash_write_enable(spi_flash_t *flash)
+{
+    // The write enable latch is set immediately, there is nothing to wait for
+    bm_spi_cs_assert(flash->spi);
+    flash_cmd_set_op(flash, FLASH_OP_WREN);
+    bm_spi_cs_deassert(flash->spi);
+}
+
+static inline void flash_wait_ready(spi_flash_t *flash)
 {
-    flash_simple_cmd(flash, FLASH_OP_WREN);
+    // The status register is output continuously as long as the chip select stays asserted
+    bm_spi_cs_assert(flash->spi);
+
+    // WIP stays set after a failed erase or program, until the error is cleared by flash_poll
+    flash_cmd_set_op(flash, FLASH_OP_RDSR);
+    while ((bm_spi_read_byte(flash->spi) & (FLASH_STATUS_WIP | FLASH_STATUS_E_ERR | FLASH_STATUS_P_ERR)) ==
+           FLASH_STATUS_WIP)
+        ;
+
+    bm_spi_cs_deassert(flash->spi);
+}
+
+/**
+ * \brief Start programming the next page of the program job
+ *
+ * \param flash FLASH device to write to
+ */
+static void flash_job_program_page(spi_flash_t *flash)
+{
+    flash_job_t *job = &flash->job;
+
+    // Calculate bytes left to the page boundary
+    uint32_t write_size = FLASH_PAGE_PROGRAM_SIZE - job->address % FLASH_PAGE_PROGRAM_SIZE;
+
+    // If we have less data to write that the rest of the page
+    if (job->length < write_size)
+        write_size = job->length;
+
+    flash_write_enable(flash);
+
+    bm_spi_cs_assert(flash->spi);
+
+    flash_cmd_set_op(flash, FLASH_OP_4PP);
+    flash_cmd_set_address(flash, job->address);
+    bm_spi_txrx_bufs(flash->spi, job->buffer, NULL, write_size);
+
+    bm_spi_cs_deassert(flash->spi);
+
+    job->length -= write_size;
+    job->address += write_size;
+    job->buffer += write_size;
+    job->poll_time = bm_get_cycles() + job->poll_interval;
+}
+
+int flash_erase_start(spi_flash_t *flash, uint32_t address)
+{
+    flash_job_t *job = &flash->job;
+
+    if (job->busy)
+    {
+        return -1;
+    }
+
+    flash_write_enable(flash);
 
     bm_spi_cs_assert(flash->spi);
 
@@ -74,64 +160,165 @@ int flash_sector_erase(spi_flash_t *flash, uint32_t address)
 
     bm_spi_cs_deassert(flash->spi);
 
-    // Wait for completion
-    while (flash_get_status(flash) & FLASH_STATUS_WIP)
-        ;
+    job->length        = 0;
+    job->error_mask    = FLASH_STATUS_E_ERR;
+    job->poll_interval = (uint64_t)FLASH_ERASE_POLL_US * (TARGET_CLK_FREQ / 1000000);
+    job->poll_time     = bm_get_cycles() + job->poll_interval;
+    job->busy          = true;
 
-    return (flash_get_status(flash) & FLASH_STATUS_E_ERR) ? -1 : 0;
+    return 0;
 }
 
-int flash_page_program(spi_flash_t *flash, uint32_t address, uint32_t length, uint8_t *buffer)
+int flash_program_start(spi_flash_t *flash, uint32_t address, uint32_t length, const uint8_t *buffer)
 {
-    while (length > 0)
+    flash_job_t *job = &flash->job;
+
+    if (job->busy)
     {
-        // Calculate bytes left to the page boundary
-        uint16_t write_size = FLASH_PAGE_PROGRAM_SIZE - address % FLASH_PAGE_PROGRAM_SIZE;
+        return -1;
+    }
 
-        // If we have less data to write that the rest of the page
-        if (length < write_size)
-            write_size = length;
+    if (length == 0)
+    {
+        return 0;
+    }
 
-        flash_simple_cmd(flash, FLASH_OP_WREN);
+    job->address       = address;
+    job->length        = length;
+    job->buffer        = buffer;
+    job->error_mask    = FLASH_STATUS_P_ERR;
+    job->poll_interval = (uint64_t)FLASH_PROGRAM_POLL_US * (TARGET_CLK_FREQ / 1000000);
+    job->busy          = true;
 
-        bm_spi_cs_assert(flash->spi);
+    flash_job_program_page(flash);
 
-        flash_cmd_set_op(flash, FLASH_OP_4PP);
-        flash_cmd_set_address(flash, address);
-        bm_spi_txrx_bufs(flash->spi, buffer, NULL, write_size);
+    return 0;
+}
 
-        bm_spi_cs_deassert(flash->spi);
+int flash_poll(spi_flash_t *flash)
+{
+    flash_job_t *job = &flash->job;
 
-        // Wait for completion
-        while (flash_get_status(flash) & FLASH_STATUS_WIP)
-            ;
+    if (!job->busy)
+    {
+        return 0;
+    }
 
-        if (flash_get_status(flash) & FLASH_STATUS_P_ERR)
-        {
-            return -1;
-        }
+    if (bm_get_cycles() < job->poll_time)
+    {
+        return FLASH_BUSY;
+    }
+
+    uint32_t status = flash_get_status(flash);
 
-        length -= write_size;
-        address += write_size;
-        buffer += write_size;
+    // Checked first, as WIP stays set after an error until the error bits are cleared
+    if (status & job->error_mask)
+    {
+        flash_simple_cmd(flash, FLASH_OP_CLSR);
+        job->busy = false;
+        return -1;
+    }
+
+    if (status & FLASH_STATUS_WIP)
+    {
+        job->poll_time = bm_get_cycles() + job->poll_interval;
+        return FLASH_BUSY;
     }
 
+    if (job->length > 0)
+    {
+        flash_job_program_page(flash);
+        return FLASH_BUSY;
+    }
+
+    job->busy = false;
     return 0;
 }
 
+int flash_wait(spi_flash_t *flash)
+{
+    int result;
+
+    while ((result = flash_poll(flash)) == FLASH_BUSY)
+    {
+        flash_wait_ready(flash);
+        flash->job.poll_time = 0;
+    }
+
+    return result;
+}
+
+int flash_sector_erase(spi_flash_t *flash, uint32_t address)
+{
+    if (flash_erase_start(flash, address))
+    {
+        return -1;
+    }
+
+    return flash_wait(flash);
+}
+
+int flash_page_program(spi_flash_t *flash, uint32_t address, uint32_t length, const uint8_t *buffer)
+{
+    if (flash_program_start(flash, address, length, buffer))
+    {
+        return -1;
+    }
+
+    return flash_wait(flash);
+}
+
 void flash_init(spi_flash_t *flash, bm_spi_t *spi)
 {
-    flash->spi = spi;
+    flash->spi       = spi;
+    flash->read_mode = FLASH_READ_NORMAL;
+    flash->job.busy  = false;
 
     flash_simple_cmd(flash, FLASH_OP_RST);
 }
 
+int flash_set_read_mode(spi_flash_t *flash, flash_read_mode_t mode)
+{
+    if (mode == FLASH_READ_QUAD)
+    {
+        uint8_t regs[2] = {flash_get_status(flash), flash_read_register(flash, FLASH_OP_RDCR)};
+
+        if (!(regs[1] & FLASH_CONFIG_QUAD))
+        {
+            regs[1] |= FLASH_CONFIG_QUAD;
+
+            flash_simple_cmd(flash, FLASH_OP_WREN);
+
+            bm_spi_cs_assert(flash->spi);
+            flash_cmd_set_op(flash, FLASH_OP_WRR);
+            bm_spi_txrx_bufs(flash->spi, regs, NULL, 2);
+            bm_spi_cs_deassert(flash->spi);
+
+            // Wait for completion
+            while (flash_get_status(flash) & FLASH_STATUS_WIP)
+                ;
+
+            if (!(flash_read_register(flash, FLASH_OP_RDCR) & FLASH_CONFIG_QUAD))
+            {
+                return -1;
+            }
+        }
+    }
+
+    flash->read_mode = mode;
+    return 0;
+}
+
 void flash_read(spi_flash_t *flash, uint32_t address, uint32_t length, uint8_t *buffer)
 {
     bm_spi_cs_assert(flash->spi);
 
-    flash_cmd_set_op(flash, FLASH_OP_4READ);
+    flash_cmd_set_op(flash, flash_read_cmds[flash->read_mode].op);
     flash_cmd_set_address(flash, address);
+
+    // Dummy cycles, the data sent are ignored
+    bm_spi_txrx_bufs(flash->spi, NULL, NULL, flash_read_cmds[flash->read_mode].dummy_bytes);
+
     bm_spi_txrx_bufs(flash->spi, NULL, buffer, length);
 
     bm_spi_cs_deassert(flash->spi);
@@ -5,15 +5,40 @@
 #define CODASIP_FLASH_H
 
 #include <baremetal/spi.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** \brief Read commands, the dual and quad ones need the Quad SPI IP configured in the dual or quad mode */
+typedef enum {
+    FLASH_READ_NORMAL, // Single lane, no dummy cycles
+    FLASH_READ_FAST,   // Single lane, 8 dummy cycles, for higher SCK frequencies
+    FLASH_READ_DUAL,   // Dual output, 8 dummy cycles
+    FLASH_READ_QUAD,   // Quad output, 8 dummy cycles, sets the Quad bit in the configuration register
+} flash_read_mode_t;
+
+/** \brief Value returned by flash_poll while the job is in progress */
+#define FLASH_BUSY 1
+
+/** \brief State of the erase or program job started by flash_erase_start or flash_program_start */
+typedef struct {
+    uint32_t       address;       ///< Address of the next page to program
+    uint32_t       length;        ///< Number of bytes left to program
+    const uint8_t *buffer;        ///< Data left to program
+    uint64_t       poll_time;     ///< Earliest time of the next status read in cycles
+    uint64_t       poll_interval; ///< Interval between the status reads in cycles
+    uint8_t        error_mask;    ///< Status bit signalling a failure of the job
+    bool           busy;          ///< Job in progress
+} flash_job_t;
+
 /** \brief Structure holding data neccessary to service the SPI flash device. */
 typedef struct {
-    bm_spi_t *spi; ///< Pointer to structure describing the SPI peripheral used
+    bm_spi_t         *spi;       ///< Pointer to structure describing the SPI peripheral used
+    flash_read_mode_t read_mode; ///< Command used by flash_read
+    flash_job_t       job;       ///< Erase or program job in progress
 } spi_flash_t;
 
 /**
@@ -24,6 +49,19 @@ typedef struct {
  */
 void flash_init(spi_flash_t *flash, bm_spi_t *spi);
 
+/**
+ * \brief Select the command used to read data from S25FL128S FLASH device
+ *
+ * The quad mode needs the Quad bit in the non-volatile configuration register, which is only
+ * written if it is not set yet. The WP# and HOLD# pins then serve as data lanes.
+ *
+ * \param flash FLASH device to configure
+ * \param mode Read command to use
+ *
+ * \return Zero on success non-zero otherwise
+ */
+int flash_set_read_mode(spi_flash_t *flash, flash_read_mode_t mode);
+
 /**
  * \brief Read data from S25FL128S FLASH device
  *
@@ -62,7 +100,7 @@ int flash_write(spi_flash_t *flash, uint32_t address, uint32_t count, uint8_t *b
  *
  * \return Zero on success non-zero otherwise
  */
-int flash_page_program(spi_flash_t *flash, uint32_t address, uint32_t length, uint8_t *buffer);
+int flash_page_program(spi_flash_t *flash, uint32_t address, uint32_t length, const uint8_t *buffer);
 
 /**
  * \brief Erase an erase sector of S25FL128S FLASH device
@@ -74,6 +112,55 @@ int flash_page_program(spi_flash_t *flash, uint32_t address, uint32_t length, ui
  */
 int flash_sector_erase(spi_flash_t *flash, uint32_t address);
 
+/**
+ * \brief Start erasing an erase sector of S25FL128S FLASH device without waiting for completion
+ *
+ * \param flash FLASH device to work with
+ * \param address Address in the erase sector to erase
+ *
+ * \return Zero on success, non-zero if another job is in progress
+ */
+int flash_erase_start(spi_flash_t *flash, uint32_t address);
+
+/**
+ * \brief Start programming pages of S25FL128S FLASH device without waiting for completion
+ *
+ * The first page is programmed immediately, the following ones by flash_poll once the previous
+ * one completes. The data must stay valid until the job completes, see \ref flash_page_program
+ * for the restrictions.
+ *
+ * \param flash FLASH device to write to
+ * \param address Address in the FLASH memory to start the write at
+ * \param length Number of bytes to write
+ * \param buffer Data to write
+ *
+ * \return Zero on success, non-zero if another job is in progress
+ */
+int flash_program_start(spi_flash_t *flash, uint32_t address, uint32_t length, const uint8_t *buffer);
+
+/**
+ * \brief Check the progress of the erase or program job
+ *
+ * The status register is only read once the poll interval of the job elapses, more frequent calls
+ * return without accessing the SPI bus. Can be called e.g. from a timer interrupt handler, as long
+ * as the interrupted code does not use the same SPI device.
+ *
+ * \param flash FLASH device to check
+ *
+ * \return FLASH_BUSY while the job is in progress, zero once it completed successfully or if there
+ *         was no job, negative value if the job failed
+ */
+int flash_poll(spi_flash_t *flash);
+
+/**
+ * \brief Wait for the completion of the erase or program job
+ *
+ * \param flash FLASH device to wait for
+ *
+ * \return Zero on success or if there was no job, negative value if the job failed
+ */
+int flash_wait(spi_flash_t *flash);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,26 +1,351 @@
 /* Copyright 2023 Codasip s.r.o.         */
 /* SPDX-License-Identifier: BSD-3-Clause */
 
+#include "kvstore.h"
 #include "s25fl128s.h"
 
+#include <baremetal/interrupt.h>
 #include <baremetal/platform.h>
 #include <baremetal/spi.h>
 #include <baremetal/time.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define BENCHMARK_SIZE  4096
+#define PAGE_SIZE       256
+#define PROGRAM_ADDRESS 0x1000 // The second 4 KB sector, the first one holds the counter
+#define KV_ADDRESS      0x10000 // Upper half of the 4 KB parameter sectors
+#define KV_NUM_SECTORS  16
+#define KV_NUM_KEYS     32
+#define KV_NUM_HOT_KEYS 4
+#define KV_VALUE_SIZE   16
+#define KV_NUM_UPDATES  2000
+#define RMW_NUM_UPDATES 8
+
+// Widest read mode supported by the Quad SPI IP, set by CONFIG_SPI_IO_MODE
+#ifndef BENCHMARK_MAX_READ_MODE
+    #define BENCHMARK_MAX_READ_MODE FLASH_READ_FAST
+#endif
+
+static uint8_t    benchmark_buffer[BENCHMARK_SIZE];
+static uint8_t    reference_buffer[BENCHMARK_SIZE];
+static bm_spi_t  *spi;
+static kv_store_t kv;
+static uint8_t    kv_values[KV_NUM_KEYS][KV_VALUE_SIZE];
+static bool       kv_written[KV_NUM_KEYS];
+
+static const char *read_mode_names[] = {"normal", "fast", "dual output", "quad output"};
+
+/**
+ * \brief Interrupt handler for SPI
+ */
+static void spi_interrupt_handler(void)
+{
+    bm_spi_handle_irq(spi);
+}
+
+/**
+ * \brief Completion callback of the asynchronous transfer
+ *
+ * \param ctx Pointer to the completion time
+ */
+static void transfer_done(void *ctx)
+{
+    *(uint64_t *)ctx = bm_get_cycles();
+}
+
+/**
+ * \brief Print the throughput of a transfer of BENCHMARK_SIZE bytes
+ *
+ * \param name Name of the measurement
+ * \param cycles Duration of the transfer
+ */
+static void report(const char *name, uint64_t cycles)
+{
+    printf("  %-30s %9llu cycles, %6llu KB/s\n",
+           name,
+           (unsigned long long)cycles,
+           (unsigned long long)((uint64_t)BENCHMARK_SIZE * TARGET_CLK_FREQ / 1024 / cycles));
+}
+
+/**
+ * \brief Compare the SPI transfer byte by byte with the pipelined and the interrupt driven transfer,
+ *        and the read modes of the flash
+ *
+ * The raw transfers run with the chip select deasserted, so only the bus throughput is measured.
+ *
+ * \param flash Flash device
+ */
+static void benchmark(spi_flash_t *flash)
+{
+    uint64_t start;
+
+    printf("\nReading %u bytes:\n", BENCHMARK_SIZE);
+
+    start = bm_get_cycles();
+    for (unsigned i = 0; i < BENCHMARK_SIZE; ++i)
+    {
+        benchmark_buffer[i] = bm_spi_read_byte(spi);
+    }
+    report("SPI byte by byte", bm_get_cycles() - start);
+
+    start = bm_get_cycles();
+    bm_spi_txrx_bufs(spi, NULL, benchmark_buffer, BENCHMARK_SIZE);
+    report("SPI pipelined", bm_get_cycles() - start);
+
+    // The dual and quad modes only return the right data if the Quad SPI IP is configured for them
+    flash_read(flash, 0x0, BENCHMARK_SIZE, reference_buffer);
+
+    for (unsigned mode = FLASH_READ_NORMAL; mode <= BENCHMARK_MAX_READ_MODE; ++mode)
+    {
+        char name[32];
+
+        if (flash_set_read_mode(flash, (flash_read_mode_t)mode))
+        {
+            printf("  flash_read, %-18s failed to enable the mode\n", read_mode_names[mode]);
+            continue;
+        }
+
+        start = bm_get_cycles();
+        flash_read(flash, 0x0, BENCHMARK_SIZE, benchmark_buffer);
+        uint64_t cycles = bm_get_cycles() - start;
+
+        snprintf(name, sizeof(name), "flash_read, %s", read_mode_names[mode]);
+        report(name, cycles);
+
+        if (memcmp(benchmark_buffer, reference_buffer, BENCHMARK_SIZE))
+        {
+            puts("    data mismatch, check CONFIG_SPI_IO_MODE against the SPI configuration");
+        }
+    }
+
+    flash_set_read_mode(flash, FLASH_READ_NORMAL);
+
+    // The CPU is free to compute while the interrupts move the data
+    uint64_t end        = 0;
+    unsigned iterations = 0;
+
+    start = bm_get_cycles();
+    bm_spi_transfer_async(spi, NULL, benchmark_buffer, BENCHMARK_SIZE, transfer_done, &end);
+    while (bm_spi_transfer_busy(spi))
+    {
+        iterations++;
+    }
+    report("SPI interrupt driven", end - start);
+    printf("  %u loop iterations done by the CPU during the transfer\n", iterations);
+}
+
+/**
+ * \brief Generate the data of a page to program, stands for the work done by the application
+ *
+ * \param index Index of the page in the benchmark buffer
+ */
+static void prepare_page(unsigned index)
+{
+    uint8_t *page  = benchmark_buffer + index * PAGE_SIZE;
+    uint32_t state = index * 2654435761u + 1;
+
+    for (unsigned i = 0; i < PAGE_SIZE; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        page[i] = state;
+    }
+}
+
+/**
+ * \brief Check the programmed data
+ *
+ * \param flash Flash device
+ */
+static void verify_program(spi_flash_t *flash)
+{
+    flash_read(flash, PROGRAM_ADDRESS, BENCHMARK_SIZE, reference_buffer);
+
+    if (memcmp(benchmark_buffer, reference_buffer, BENCHMARK_SIZE))
+    {
+        puts("    data mismatch");
+    }
+}
+
+/**
+ * \brief Compare the blocking erase and program with the jobs overlapping the data preparation
+ *
+ * \param flash Flash device
+ */
+static void benchmark_program(spi_flash_t *flash)
+{
+    uint64_t start;
+
+    printf("\nErasing and programming %u pages:\n", BENCHMARK_SIZE / PAGE_SIZE);
+
+    start = bm_get_cycles();
+    flash_sector_erase(flash, PROGRAM_ADDRESS);
+    for (unsigned i = 0; i < BENCHMARK_SIZE / PAGE_SIZE; ++i)
+    {
+        prepare_page(i);
+        flash_page_program(flash, PROGRAM_ADDRESS + i * PAGE_SIZE, PAGE_SIZE, benchmark_buffer + i * PAGE_SIZE);
+    }
+    report("blocking", bm_get_cycles() - start);
+    verify_program(flash);
+
+    // Each page is prepared while the previous one is programmed, the first one during the erase
+    unsigned polls = 0;
+
+    start = bm_get_cycles();
+    flash_erase_start(flash, PROGRAM_ADDRESS);
+    prepare_page(0);
+    while (flash_poll(flash) == FLASH_BUSY)
+    {
+        polls++;
+    }
+    for (unsigned i = 0; i < BENCHMARK_SIZE / PAGE_SIZE; ++i)
+    {
+        flash_program_start(flash, PROGRAM_ADDRESS + i * PAGE_SIZE, PAGE_SIZE, benchmark_buffer + i * PAGE_SIZE);
+        if (i + 1 < BENCHMARK_SIZE / PAGE_SIZE)
+        {
+            prepare_page(i + 1);
+        }
+        flash_wait(flash);
+    }
+    report("pipelined jobs", bm_get_cycles() - start);
+    printf("  %u calls of flash_poll during the erase, most of them without accessing the bus\n", polls);
+    verify_program(flash);
+}
+
+/**
+ * \brief Print the rate of updates
+ *
+ * \param name Name of the measurement
+ * \param updates Number of updates
+ * \param cycles Duration of the updates
+ */
+static void report_updates(const char *name, unsigned updates, uint64_t cycles)
+{
+    printf("  %-30s %9llu cycles, %6llu updates/s\n",
+           name,
+           (unsigned long long)cycles,
+           (unsigned long long)((uint64_t)updates * TARGET_CLK_FREQ / cycles));
+}
+
+/**
+ * \brief Compare updating small values in place with the key-value store
+ *
+ * Updating in place rewrites the whole 4 KB sector, the store appends a record and erases a
+ * sector only once per compaction. Most of the updates go to a few hot keys, as with counters
+ * next to rarely changed calibration data.
+ *
+ * \param flash Flash device
+ */
+static void benchmark_kvstore(spi_flash_t *flash)
+{
+    uint64_t   start;
+    uint32_t   state = 1;
+    kv_stats_t stats;
+
+    printf("\nUpdating %u byte values:\n", KV_VALUE_SIZE);
+
+    start = bm_get_cycles();
+    for (unsigned i = 0; i < RMW_NUM_UPDATES; ++i)
+    {
+        flash_write(flash, PROGRAM_ADDRESS + i * KV_VALUE_SIZE, KV_VALUE_SIZE, kv_values[i]);
+    }
+    report_updates("flash_write in place", RMW_NUM_UPDATES, bm_get_cycles() - start);
+    printf("  write amplification %u\n", KV_SECTOR_SIZE / KV_VALUE_SIZE);
+
+    if (kv_mount(&kv, flash, KV_ADDRESS, KV_NUM_SECTORS) || kv_format(&kv) ||
+        kv_mount(&kv, flash, KV_ADDRESS, KV_NUM_SECTORS))
+    {
+        puts("  failed to mount the key-value store");
+        return;
+    }
+
+    start = bm_get_cycles();
+    for (unsigned i = 0; i < KV_NUM_UPDATES; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        unsigned key = (state & 3) ? (state >> 8) % KV_NUM_HOT_KEYS : (state >> 8) % KV_NUM_KEYS;
+        memcpy(kv_values[key], &state, sizeof(state));
+        kv_written[key] = true;
+
+        if (kv_set(&kv, key, kv_values[key], KV_VALUE_SIZE))
+        {
+            puts("  kv_set failed");
+            return;
+        }
+
+        // Stands for the idle time of the application
+        if (i % 16 == 0)
+        {
+            kv_compact_step(&kv);
+        }
+    }
+    uint64_t cycles = bm_get_cycles() - start;
+
+    kv_get_stats(&kv, &stats);
+    report_updates("key-value store", KV_NUM_UPDATES, cycles);
+    printf("  write amplification %u.%02u, %u erases, %u compactions\n",
+           (unsigned)(stats.flash_bytes / stats.user_bytes),
+           (unsigned)(stats.flash_bytes % stats.user_bytes * 100 / stats.user_bytes),
+           (unsigned)stats.erases,
+           (unsigned)stats.compactions);
+
+    unsigned min_erases = kv.sectors[0].erase_count;
+    unsigned max_erases = kv.sectors[0].erase_count;
+    for (unsigned i = 1; i < KV_NUM_SECTORS; ++i)
+    {
+        min_erases = kv.sectors[i].erase_count < min_erases ? kv.sectors[i].erase_count : min_erases;
+        max_erases = kv.sectors[i].erase_count > max_erases ? kv.sectors[i].erase_count : max_erases;
+    }
+    printf("  sectors erased %u to %u times\n", min_erases, max_erases);
+
+    // The index is rebuilt from the records, as after a reset
+    start = bm_get_cycles();
+    if (kv_mount(&kv, flash, KV_ADDRESS, KV_NUM_SECTORS))
+    {
+        puts("  failed to remount the key-value store");
+        return;
+    }
+    printf("  remounted in %llu cycles\n", (unsigned long long)(bm_get_cycles() - start));
+
+    for (unsigned key = 0; key < KV_NUM_KEYS; ++key)
+    {
+        uint8_t value[KV_VALUE_SIZE];
+
+        if (!kv_written[key])
+        {
+            continue;
+        }
+
+        // A key missing after the remount is reported as well
+        if (kv_get(&kv, key, value, sizeof(value)) != KV_VALUE_SIZE || memcmp(value, kv_values[key], KV_VALUE_SIZE))
+        {
+            printf("    data mismatch of key %u\n", key);
+        }
+    }
+}
 
 /**
  * \brief SPI Master demo
  *
- * Reads out the counter from the flash memory, increments it and writes back.
+ * Reads out the counter from the flash memory, increments it and writes back. Then measures the
+ * read throughput, the duration of erasing and programming a sector, and the rate of updates
+ * of the key-value store.
  */
 int main(void)
 {
     puts("Welcome to the SPI demo!\n");
 
-    bm_spi_t   *spi = (bm_spi_t *)target_peripheral_get(BM_PERIPHERAL_SPI_FLASH);
     spi_flash_t flash;
 
+    spi = (bm_spi_t *)target_peripheral_get(BM_PERIPHERAL_SPI_FLASH);
+
     bm_spi_init(spi);
     flash_init(&flash, spi);
 
@@ -48,6 +373,14 @@ int main(void)
     ++counter;
     flash_write(&flash, 0x3, 1, (uint8_t *)&counter);
 
-    puts("Bye.");
+    bm_ext_irq_set_handler(spi->ext_irq_id, spi_interrupt_handler);
+    bm_interrupt_enable_source(BM_PRIV_MODE_MACHINE, BM_INTERRUPT_MEIP);
+    bm_interrupt_init(BM_PRIV_MODE_MACHINE);
+
+    benchmark(&flash);
+    benchmark_program(&flash);
+    benchmark_kvstore(&flash);
+
+    puts("\nBye.");
     return EXIT_SUCCESS;
 }
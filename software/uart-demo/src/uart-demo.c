@@ -5,8 +5,10 @@
 #include <baremetal/platform.h>
 #include <baremetal/time.h>
 #include <baremetal/uart.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // Configuration of the demo
 #define USE_IRQ 1
@@ -20,10 +22,7 @@ static bm_uart_t *uart;
  */
 static inline void write_line(const char *str)
 {
-    while (*str != 0)
-    {
-        bm_uart_transmit_byte(uart, *str++);
-    }
+    bm_uart_write(uart, (const uint8_t *)str, strlen(str));
 }
 
 /**